@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <errno.h> // program_invocation_short_name
+
+namespace bench {
+    // prevents the compiler from optimizing away a computed value
+    template<class T>
+    inline void keep(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // runs func(i) for i in [0, iterations) and returns the average time per call in ns
+    template<class Func>
+    double ns_per_op(std::size_t iterations, Func&& func) {
+        auto start = std::chrono::steady_clock::now();
+        for(std::size_t i = 0; i < iterations; ++i) func(i);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / static_cast<double>(iterations);
+    }
+
+    // sorts samples and returns the value at percentile p [0, 100]
+    inline double percentile(std::vector<double>& samples, double p) {
+        if(samples.empty()) return 0;
+        std::sort(samples.begin(), samples.end());
+        auto idx = static_cast<std::size_t>(p / 100 * static_cast<double>(samples.size() - 1) + 0.5);
+        return samples[idx];
+    }
+
+    // a named value in a result, the key should include the unit
+    struct metric {
+        const char* key;
+        double value;
+    };
+
+    namespace detail {
+        inline std::string json_string(std::string_view str) {
+            std::string res = "\"";
+            for(char ch : str) {
+                if(ch == '"' || ch == '\\') {
+                    res += '\\';
+                    res += ch;
+                } else if(static_cast<unsigned char>(ch) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof buf, "\\u%04x", ch);
+                    res += buf;
+                } else {
+                    res += ch;
+                }
+            }
+            return res += '"';
+        }
+
+        // The results are appended, one JSON object per line, to the file
+        // named by the environment variable LYN_BENCH_JSON, if it's set.
+        // LYN_BENCH_COMMIT is included in every result to be able to track
+        // the results over time. "make json" sets both.
+        inline void write_json(const char* name, std::initializer_list<metric> metrics) {
+            static std::FILE* file = [] {
+                const char* path = std::getenv("LYN_BENCH_JSON");
+                return path && *path ? std::fopen(path, "a") : nullptr;
+            }();
+            if(file == nullptr) return;
+
+            static const std::string common = [] {
+                const char* commit = std::getenv("LYN_BENCH_COMMIT");
+                return "{\"bench\":" + json_string(program_invocation_short_name) +
+                       ",\"commit\":" + json_string(commit ? commit : "") + ",\"compiler\":" + json_string(__VERSION__);
+            }();
+            std::string line = common + ",\"name\":" + json_string(name);
+            for(auto& m : metrics) {
+                char buf[64];
+                std::snprintf(buf, sizeof buf, ":%.3f", m.value);
+                line += ',' + json_string(m.key) + buf;
+            }
+            line += "}\n";
+            std::fputs(line.c_str(), file);
+            std::fflush(file);
+        }
+    } // namespace detail
+
+    inline void report(const char* name, double ns) {
+        std::printf("%-56s %12.2f ns/op\n", name, ns);
+        detail::write_json(name, {{"ns_per_op", ns}});
+    }
+
+    inline void report_metrics(const char* name, std::initializer_list<metric> metrics) {
+        std::printf("%-56s", name);
+        for(auto& m : metrics) std::printf(" %s %.2f", m.key, m.value);
+        std::printf("\n");
+        detail::write_json(name, metrics);
+    }
+
+    inline void report_latency(const char* name, std::vector<double>& samples) {
+        auto p50 = percentile(samples, 50), p99 = percentile(samples, 99), p999 = percentile(samples, 99.9),
+             max = percentile(samples, 100);
+        std::printf("%-56s p50 %8.1f  p99 %8.1f  p99.9 %8.1f  max %10.1f ns\n", name, p50, p99, p999, max);
+        detail::write_json(name, {{"p50_ns", p50}, {"p99_ns", p99}, {"p99_9_ns", p999}, {"max_ns", max}});
+    }
+} // namespace bench
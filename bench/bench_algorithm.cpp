@@ -0,0 +1,53 @@
+#include "bench.hpp"
+#include "lyn/algorithm.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// unstable_erase_if compared to the erase-remove_if idiom at different
+// sizes and ratios of removed elements. Reported as ns per element in the
+// vector before erasing.
+
+constexpr std::size_t elements_per_size = 10'000'000; // total number of elements processed per size
+
+template<class Erase>
+double ns_per_element(const std::vector<int>& source, Erase&& erase) {
+    std::vector<int> work;
+    std::chrono::duration<double, std::nano> elapsed{};
+    auto repetitions = std::max<std::size_t>(1, elements_per_size / source.size());
+    for(std::size_t r = 0; r < repetitions; ++r) {
+        work = source;
+        auto start = std::chrono::steady_clock::now();
+        erase(work);
+        elapsed += std::chrono::steady_clock::now() - start;
+        bench::keep(work.size());
+    }
+    return elapsed.count() / static_cast<double>(repetitions * source.size());
+}
+
+int main() {
+    char name[64];
+    std::mt19937 gen(4711);
+    std::uniform_int_distribution<int> dist(0, 99);
+
+    for(std::size_t size : {1'000, 100'000, 1'000'000}) {
+        std::vector<int> source(size);
+        for(auto& v : source) v = dist(gen);
+
+        for(int percent : {1, 10, 50, 90}) {
+            auto pred = [percent](int v) { return v < percent; };
+
+            std::snprintf(name, sizeof name, "unstable_erase_if, %zu elements, %d%% removed", size, percent);
+            bench::report_metrics(name, {{"ns_per_element", ns_per_element(source, [&](std::vector<int>& v) {
+                                              lyn::alg::unstable_erase_if(v, pred);
+                                          })}});
+            std::snprintf(name, sizeof name, "erase(remove_if), %zu elements, %d%% removed", size, percent);
+            bench::report_metrics(name, {{"ns_per_element", ns_per_element(source, [&](std::vector<int>& v) {
+                                              v.erase(std::remove_if(v.begin(), v.end(), pred), v.end());
+                                          })}});
+        }
+    }
+}
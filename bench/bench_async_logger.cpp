@@ -0,0 +1,92 @@
+#include "bench.hpp"
+#include "lyn/async_logger.hpp"
+
+#include <chrono>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// producer side latency of async_logger::log compared to synchronous
+// streaming through log_watch, both writing to /dev/null
+
+constexpr std::size_t messages_per_thread = 200'000;
+
+template<class Func>
+std::vector<double> producer_latency(unsigned threads, Func&& log_one) {
+    std::vector<std::vector<double>> per_thread(threads);
+    std::vector<std::thread> ths;
+    for(unsigned t = 0; t < threads; ++t) {
+        ths.emplace_back([&, t] {
+            auto& samples = per_thread[t];
+            samples.reserve(messages_per_thread);
+            for(std::size_t i = 0; i < messages_per_thread; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                log_one(t, i);
+                std::chrono::duration<double, std::nano> dur = std::chrono::steady_clock::now() - start;
+                samples.push_back(dur.count());
+            }
+        });
+    }
+    for(auto& th : ths) th.join();
+
+    std::vector<double> all;
+    for(auto& s : per_thread) all.insert(all.end(), s.begin(), s.end());
+    return all;
+}
+
+int main() {
+    int devnull = ::open("/dev/null", O_WRONLY);
+    if(devnull < 0) return 1;
+
+    for(unsigned threads : {1U, 4U}) {
+        char name[64];
+        {
+            lyn::async_logger<> logger(devnull, 1 << 16, lyn::overflow_policy::block);
+            logger.start();
+            auto samples = producer_latency(threads, [&](unsigned t, std::size_t i) {
+                logger.log("thread ", t, " message ", i, " value ", 3.14159);
+            });
+            std::snprintf(name, sizeof name, "async_logger::log (block) %u threads", threads);
+            bench::report_latency(name, samples);
+        }
+        {
+            // strings are copied into the record, not into std::strings
+            lyn::async_logger<> logger(devnull, 1 << 16, lyn::overflow_policy::block);
+            logger.start();
+            std::string path(100, 'p');
+            auto samples = producer_latency(threads, [&](unsigned t, std::size_t i) {
+                logger.log("thread ", t, " message ", i, " path ", std::string_view(path));
+            });
+            std::snprintf(name, sizeof name, "async_logger::log (block) %u threads, 100 byte string", threads);
+            bench::report_latency(name, samples);
+        }
+        {
+            lyn::async_logger<> logger(devnull, 1024, lyn::overflow_policy::drop);
+            logger.start();
+            auto samples = producer_latency(threads, [&](unsigned t, std::size_t i) {
+                logger.log("thread ", t, " message ", i, " value ", 3.14159);
+            });
+            logger.shutdown();
+            std::snprintf(name, sizeof name, "async_logger::log (drop) %u threads", threads);
+            bench::report_latency(name, samples);
+            std::snprintf(name, sizeof name, "async_logger::log (drop) %u threads, dropped", threads);
+            bench::report_metrics(name, {{"dropped", static_cast<double>(logger.dropped())},
+                                         {"logged", static_cast<double>(threads * messages_per_thread)}});
+        }
+        {
+            std::ofstream os("/dev/null");
+            std::mutex mtx;
+            lyn::log_watch<std::chrono::microseconds> lw("%FT%T.");
+            auto samples = producer_latency(threads, [&](unsigned t, std::size_t i) {
+                std::lock_guard<std::mutex> lock(mtx);
+                os << lw(std::chrono::system_clock::now()) << " thread " << t << " message " << i << " value "
+                   << 3.14159 << '\n';
+            });
+            std::snprintf(name, sizeof name, "log_watch operator<< %u threads", threads);
+            bench::report_latency(name, samples);
+        }
+    }
+    ::close(devnull);
+}
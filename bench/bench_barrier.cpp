@@ -0,0 +1,76 @@
+#include "bench.hpp"
+#include "lyn/barrier.hpp"
+#include "lyn/thread.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Phases per second for 1-16 threads repeatedly meeting at a barrier: a
+// shared count under a mutex with wait_for_then, as in the README ping-pong,
+// compared to barrier and combining_barrier. Reported as ns per phase.
+
+constexpr int phases = 20'000;
+
+// the pattern barrier replaces
+class counting_barrier {
+public:
+    explicit counting_barrier(int expected) : m_expected(expected) {}
+
+    void arrive_and_wait() {
+        unsigned phase;
+        bool last = lyn::thread::guard_then_notify_using<lyn::thread::notifier_of_none>(m_cvmtx, [&] {
+            phase = m_phase;
+            if(++m_count < m_expected) return false;
+            m_count = 0;
+            ++m_phase;
+            return true;
+        });
+        if(last)
+            m_cvmtx.cv.notify_all();
+        else
+            lyn::thread::wait_for_then(m_cvmtx, [&] { return m_phase != phase; }, [] {});
+    }
+
+private:
+    lyn::thread::cv_mtx_pair m_cvmtx;
+    int m_expected;
+    int m_count = 0;
+    unsigned m_phase = 0;
+};
+
+template<class Func>
+double run(int threads, Func&& arrive_and_wait) {
+    std::vector<std::thread> ths;
+    auto start = std::chrono::steady_clock::now();
+    for(int t = 0; t < threads; ++t) {
+        ths.emplace_back([&, t] {
+            for(int p = 0; p < phases; ++p) arrive_and_wait(t);
+        });
+    }
+    for(auto& th : ths) th.join();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / phases;
+}
+
+int main() {
+    char name[64];
+    for(int threads : {1, 2, 4, 8, 16}) {
+        {
+            counting_barrier b(threads);
+            std::snprintf(name, sizeof name, "mutex + wait_for_then, %d threads", threads);
+            bench::report(name, run(threads, [&](int) { b.arrive_and_wait(); }));
+        }
+        {
+            lyn::thread::barrier<> b(static_cast<std::uint32_t>(threads));
+            std::snprintf(name, sizeof name, "barrier, %d threads", threads);
+            bench::report(name, run(threads, [&](int) { b.arrive_and_wait(); }));
+        }
+        {
+            lyn::thread::combining_barrier<> b(static_cast<std::size_t>(threads));
+            std::snprintf(name, sizeof name, "combining_barrier, %d threads", threads);
+            bench::report(name, run(threads, [&](int t) { b.arrive_and_wait(static_cast<std::size_t>(t)); }));
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#include "bench.hpp"
+#include "lyn/broadcast_queue.hpp"
+#include "lyn/message_queue.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Fanning out messages to 1-8 subscribers: one broadcast_queue compared to
+// pushing a copy of each message into one message_queue per subscriber.
+// Reported as ns per message delivered to all subscribers.
+
+constexpr int messages = 500'000;
+const std::string payload(64, 'x');
+
+double broadcast(int subscribers) {
+    lyn::mq::broadcast_queue<std::string> bq(4096);
+    std::vector<std::thread> threads;
+    for(int s = 0; s < subscribers; ++s) {
+        threads.emplace_back([sub = bq.subscribe()]() mutable {
+            for(int i = 0; i < messages; ++i) bench::keep(sub.next()->size());
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < messages; ++i) bq.push(payload);
+    for(auto& th : threads) th.join();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / messages;
+}
+
+double queue_per_subscriber(int subscribers) {
+    std::vector<std::unique_ptr<lyn::mq::message_queue<std::string>>> queues;
+    std::vector<std::thread> threads;
+    for(int s = 0; s < subscribers; ++s) {
+        queues.emplace_back(std::make_unique<lyn::mq::message_queue<std::string>>());
+        threads.emplace_back([&mq = *queues.back()] {
+            for(int i = 0; i < messages; ++i) bench::keep(mq.pop().size());
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < messages; ++i) {
+        for(auto& mq : queues) mq->push(payload);
+    }
+    for(auto& th : threads) th.join();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / messages;
+}
+
+int main() {
+    char name[64];
+    for(int subscribers : {1, 2, 4, 8}) {
+        std::snprintf(name, sizeof name, "broadcast_queue, %d subscribers", subscribers);
+        bench::report(name, broadcast(subscribers));
+        std::snprintf(name, sizeof name, "message_queue per subscriber, %d subscribers", subscribers);
+        bench::report(name, queue_per_subscriber(subscribers));
+    }
+}
@@ -0,0 +1,26 @@
+#include "bench.hpp"
+#include "lyn/clock.hpp"
+
+#include <chrono>
+
+// the cost per call of now() for the clock adapters in lyn/clock.hpp
+
+template<class Clock>
+double now_cost() {
+    return bench::ns_per_op(10'000'000, [](std::size_t) { bench::keep(Clock::now()); });
+}
+
+int main() {
+    bench::report("std::chrono::system_clock::now", now_cost<std::chrono::system_clock>());
+    bench::report("std::chrono::steady_clock::now", now_cost<std::chrono::steady_clock>());
+#ifdef LYN_HAS_COARSE_SYSTEM_CLOCK
+    bench::report("lyn::chrono::coarse_system_clock::now", now_cost<lyn::chrono::coarse_system_clock>());
+#endif
+#ifdef LYN_HAS_TSC_CLOCK
+    lyn::chrono::tsc_clock::calibrate();
+    bench::report("lyn::chrono::tsc_clock::now", now_cost<lyn::chrono::tsc_clock>());
+#endif
+    lyn::chrono::cached_clock<>::updater upd(std::chrono::milliseconds(1));
+    upd.start();
+    bench::report("lyn::chrono::cached_clock<>::now", now_cost<lyn::chrono::cached_clock<>>());
+}
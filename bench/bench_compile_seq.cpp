@@ -0,0 +1,85 @@
+#include "bench.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Compile time cost of the lyn::seq operations: the time and peak memory
+// usage of the compiler instantiating them on sequences of 256-8192
+// values, compared to the previous tuple based reverse_sequence. That one
+// exceeds the default template instantiation depth (900 in g++) at 512.
+
+#ifndef BENCH_CXX
+#define BENCH_CXX "c++"
+#endif
+
+struct op {
+    int id;
+    const char* name;
+    int max_n;
+};
+
+// The constexpr evaluation limits are raised for sort_t. The options
+// differ between g++ and clang++ so ask the preprocessor which one it is.
+bool is_clang() {
+    FILE* pp = popen(BENCH_CXX " -dM -E -x c++ /dev/null", "r");
+    if(pp == nullptr) return false;
+    bool res = false;
+    char line[256];
+    while(std::fgets(line, sizeof line, pp)) {
+        if(std::strncmp(line, "#define __clang__ ", 18) == 0) res = true;
+    }
+    pclose(pp);
+    return res;
+}
+
+// returns false if the compilation failed
+bool compile(int id, int n, double& seconds, double& max_rss_mib) {
+    static const bool clang = is_clang();
+    std::string defines[] = {"-DLYN_SEQ_OP=" + std::to_string(id), "-DLYN_SEQ_N=" + std::to_string(n)};
+    std::vector<const char*> args{BENCH_CXX, "-std=c++14", "-I../include", "-fsyntax-only"};
+    if(clang) {
+        args.push_back("-fconstexpr-steps=1000000000");
+    } else {
+        args.push_back("-fconstexpr-ops-limit=1000000000");
+        args.push_back("-fconstexpr-loop-limit=1000000");
+    }
+    args.insert(args.end(), {defines[0].c_str(), defines[1].c_str(), "compile_seq.cpp", nullptr});
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if(pid == 0) {
+        execvp(BENCH_CXX, const_cast<char* const*>(args.data()));
+        _exit(127);
+    }
+    int status;
+    rusage usage;
+    if(pid == -1 || wait4(pid, &status, 0, &usage) != pid) return false;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    seconds = elapsed.count();
+    max_rss_mib = static_cast<double>(usage.ru_maxrss) / 1024;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main() {
+    const op ops[] = {{0, "tuple based reverse_sequence", 256}, {1, "lyn::seq::reverse_t", 8192},
+                      {2, "lyn::seq::concat_t, 4 sequences", 8192}, {3, "lyn::seq::slice_t", 8192},
+                      {4, "lyn::seq::filter_t", 8192},           {5, "lyn::seq::sort_t", 8192}};
+    char name[64];
+    for(auto& o : ops) {
+        for(int n = 256; n <= o.max_n; n *= 2) {
+            double seconds, max_rss_mib;
+            if(not compile(o.id, n, seconds, max_rss_mib)) {
+                std::fprintf(stderr, "%s: compilation failed with %d values\n", o.name, n);
+                return 1;
+            }
+            std::snprintf(name, sizeof name, "%s, %d values", o.name, n);
+            bench::report_metrics(name, {{"compile_s", seconds}, {"max_rss_mib", max_rss_mib}});
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#include "bench.hpp"
+#include "lyn/message_queue.hpp"
+#include "lyn/thread.hpp"
+#include "lyn/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// 100k coroutines suspended in message_queue::async_pop / event::async_wait
+// at the same time, resumed by push() / set() via an executor
+
+constexpr int waiters = 100'000;
+
+std::atomic<int> resumed{};
+lyn::thread::event<true> all_resumed;
+
+void count_resume() {
+    if(++resumed == waiters) all_resumed.set();
+}
+
+lyn::thread::detached_task pop_one(lyn::mq::message_queue<int>& mq, lyn::thread::executor& ex) {
+    bench::keep(co_await mq.async_pop(ex));
+    count_resume();
+}
+
+template<bool AutoReset>
+lyn::thread::detached_task wait_one(lyn::thread::event<AutoReset>& ev, lyn::thread::executor& ex) {
+    co_await ev.async_wait(ex);
+    count_resume();
+}
+
+// an idle timeout that is signaled long before it expires
+lyn::thread::detached_task wait_for_one(lyn::thread::event<true>& ev, lyn::thread::executor& ex) {
+    bench::keep(co_await ev.async_wait_for(std::chrono::hours(1), ex));
+    count_resume();
+}
+
+template<class Suspend, class Release>
+void run(const std::string& name, Suspend&& suspend, Release&& release) {
+    resumed = 0;
+    for(int i = 0; i < waiters; ++i) suspend();
+    auto start = std::chrono::steady_clock::now();
+    release();
+    all_resumed.wait();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    bench::report(name.c_str(), elapsed.count() / waiters);
+}
+
+int main() {
+    lyn::thread::thread_pool pool;
+    lyn::thread::inline_executor inline_ex;
+
+    for(lyn::thread::executor* ex : {static_cast<lyn::thread::executor*>(&inline_ex),
+                                     static_cast<lyn::thread::executor*>(&pool)}) {
+        std::string exname = ex == &pool ? " (thread_pool " + std::to_string(pool.size()) + ")" : " (inline)";
+
+        lyn::mq::message_queue<int> mq;
+        run(
+            "message_queue::async_pop 100k waiters" + exname, [&] { pop_one(mq, *ex); },
+            [&] {
+                for(int i = 0; i < waiters; ++i) mq.push(i);
+            });
+
+        lyn::thread::event<true> aev;
+        run(
+            "event<true>::async_wait 100k waiters" + exname, [&] { wait_one(aev, *ex); },
+            [&] {
+                for(int i = 0; i < waiters; ++i) aev.set();
+            });
+
+        lyn::thread::event<false> mev;
+        run(
+            "event<false>::async_wait 100k waiters" + exname, [&] { wait_one(mev, *ex); }, [&] { mev.set(); });
+
+        run(
+            "event<true>::async_wait_for 100k waiters" + exname, [&] { wait_for_one(aev, *ex); },
+            [&] {
+                for(int i = 0; i < waiters; ++i) aev.set();
+            });
+        // set() cancels the timeouts of the waiters it releases
+        if(auto timers = lyn::thread::detail::coroutine_timer::instance().size()) {
+            std::fprintf(stderr, "%zu timeouts left after all waiters were signaled\n", timers);
+            return 1;
+        }
+    }
+}
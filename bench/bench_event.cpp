@@ -0,0 +1,61 @@
+#include "bench.hpp"
+#include "lyn/thread.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Ping-pong between two threads: the round trip latency of signaling a
+// thread and waiting for it to signal back, using a pair of auto reset
+// events compared to a pair of std::condition_variable + bool.
+
+constexpr int round_trips = 100'000;
+
+struct cv_flag {
+    void set() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            state = true;
+        }
+        cv.notify_one();
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this] { return state; });
+        state = false;
+    }
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool state = false;
+};
+
+template<class Event>
+std::vector<double> ping_pong() {
+    Event ping, pong;
+    std::thread th([&] {
+        for(int i = 0; i < round_trips; ++i) {
+            ping.wait();
+            pong.set();
+        }
+    });
+    std::vector<double> samples;
+    samples.reserve(round_trips);
+    for(int i = 0; i < round_trips; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        ping.set();
+        pong.wait();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        samples.push_back(elapsed.count());
+    }
+    th.join();
+    return samples;
+}
+
+int main() {
+    auto samples = ping_pong<lyn::thread::event<true>>();
+    bench::report_latency("event<true> ping-pong round trip", samples);
+    samples = ping_pong<cv_flag>();
+    bench::report_latency("condition_variable ping-pong round trip", samples);
+}
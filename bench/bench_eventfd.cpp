@@ -0,0 +1,75 @@
+#include "bench.hpp"
+#include "lyn/message_queue.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+// Waking an epoll_wait thread for message_queue messages: one pipe write per
+// message compared to the coalescing eventfd mode.
+
+constexpr int messages = 1'000'000;
+
+template<class Produce, class Drain>
+void run(const char* name, int fd, Produce&& produce, Drain&& drain) {
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+
+    auto start = std::chrono::steady_clock::now();
+    auto th = std::thread(produce);
+    long received = 0, wakeups = 0;
+    while(received < messages) {
+        epoll_event out;
+        if(epoll_wait(ep, &out, 1, -1) != 1) continue;
+        ++wakeups;
+        received += drain();
+    }
+    th.join();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    bench::report_metrics(name, {{"ns_per_op", elapsed.count() / messages},
+                                 {"messages_per_wakeup", static_cast<double>(messages) / static_cast<double>(wakeups)}});
+    close(ep);
+}
+
+int main() {
+    {
+        lyn::mq::message_queue<int> mq;
+        int fds[2];
+        if(pipe2(fds, O_NONBLOCK | O_CLOEXEC)) return 1;
+        run(
+            "message_queue + pipe write per message", fds[0],
+            [&] {
+                for(int i = 0; i < messages; ++i) {
+                    mq.push(i);
+                    char ch = 0;
+                    while(write(fds[1], &ch, 1) != 1) std::this_thread::yield(); // pipe full
+                }
+            },
+            [&] {
+                char buf[4096];
+                while(read(fds[0], buf, sizeof buf) > 0) {}
+                lyn::mq::message_queue<int>::queue_t q;
+                return mq.pop_all(q) ? static_cast<long>(q.size()) : 0L;
+            });
+        close(fds[0]);
+        close(fds[1]);
+    }
+    {
+        lyn::mq::message_queue<int> mq(lyn::thread::use_eventfd);
+        run(
+            "message_queue(use_eventfd)", mq.notification_fd(),
+            [&] {
+                for(int i = 0; i < messages; ++i) mq.push(i);
+            },
+            [&] {
+                lyn::mq::message_queue<int>::queue_t q;
+                return mq.pop_all(q) ? static_cast<long>(q.size()) : 0L;
+            });
+    }
+}
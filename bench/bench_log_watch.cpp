@@ -0,0 +1,47 @@
+#include "bench.hpp"
+#include "lyn/log_watch.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+// log_watch: streaming operator<< compared to the cached format_to engine
+
+int main() {
+    using namespace std::chrono;
+    using lw_type = lyn::log_watch<microseconds>;
+
+    constexpr std::size_t iterations = 1'000'000;
+    const auto base = time_point_cast<microseconds>(system_clock::now());
+
+    lw_type lw;
+    std::ostringstream oss;
+    char buf[64];
+
+    // verify that both paths produce the same result
+    oss << lw(base);
+    if(oss.str() != std::string(buf, lw(base).format_to(buf, sizeof buf))) {
+        std::fprintf(stderr, "format mismatch: %s\n", oss.str().c_str());
+        return 1;
+    }
+
+    // one microsecond per line, the second changes every 1000000 lines
+    bench::report("log_watch operator<< (same second)", bench::ns_per_op(iterations, [&](std::size_t i) {
+                      oss.seekp(0);
+                      oss << lw(base + microseconds(i));
+                  }));
+    bench::report("log_watch format_to (same second)", bench::ns_per_op(iterations, [&](std::size_t i) {
+                      bench::keep(lw(base + microseconds(i)).format_to(buf, sizeof buf));
+                      bench::keep(buf);
+                  }));
+
+    // worst case for the cache, a new second on every line
+    bench::report("log_watch operator<< (new second)", bench::ns_per_op(iterations, [&](std::size_t i) {
+                      oss.seekp(0);
+                      oss << lw(base + seconds(i));
+                  }));
+    bench::report("log_watch format_to (new second)", bench::ns_per_op(iterations, [&](std::size_t i) {
+                      bench::keep(lw(base + seconds(i)).format_to(buf, sizeof buf));
+                      bench::keep(buf);
+                  }));
+}
@@ -0,0 +1,83 @@
+#include "bench.hpp"
+#include "lyn/message_queue.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// message_queue throughput with 1-4 producers and 1-4 consumers and the
+// latency from push to pop, measured with timestamped messages pushed at
+// a steady pace so that the queue doesn't build up.
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr std::int64_t stop = -1;
+
+std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+}
+
+// returns ns per message
+double throughput(int producers, int consumers, int messages) {
+    lyn::mq::message_queue<std::int64_t> mq;
+    std::vector<std::thread> threads;
+    for(int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&mq] {
+            while(mq.pop() != stop) {}
+        });
+    }
+    auto start = clock_type::now();
+    std::vector<std::thread> producing;
+    for(int p = 0; p < producers; ++p) {
+        producing.emplace_back([&mq, count = messages / producers] {
+            for(int i = 0; i < count; ++i) mq.push(i);
+        });
+    }
+    for(auto& th : producing) th.join();
+    for(int c = 0; c < consumers; ++c) mq.push(stop);
+    for(auto& th : threads) th.join();
+    std::chrono::duration<double, std::nano> elapsed = clock_type::now() - start;
+    return elapsed.count() / messages;
+}
+
+std::vector<double> latency(int producers, int messages) {
+    lyn::mq::message_queue<std::int64_t> mq;
+    std::vector<double> samples;
+    samples.reserve(static_cast<std::size_t>(messages));
+    std::thread consumer([&] {
+        for(int i = 0; i < messages; ++i) {
+            auto ts = mq.pop();
+            samples.push_back(static_cast<double>(now_ns() - ts));
+        }
+    });
+    std::vector<std::thread> producing;
+    for(int p = 0; p < producers; ++p) {
+        producing.emplace_back([&mq, count = messages / producers] {
+            for(int i = 0; i < count; ++i) {
+                mq.push(now_ns());
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            }
+        });
+    }
+    for(auto& th : producing) th.join();
+    consumer.join();
+    return samples;
+}
+
+int main() {
+    char name[64];
+    for(int producers : {1, 2, 4}) {
+        for(int consumers : {1, 2, 4}) {
+            auto ns = throughput(producers, consumers, 1'000'000);
+            std::snprintf(name, sizeof name, "message_queue, %d producers, %d consumers", producers, consumers);
+            bench::report_metrics(name, {{"ns_per_op", ns}, {"messages_per_s", 1e9 / ns}});
+        }
+    }
+    for(int producers : {1, 2, 4}) {
+        auto samples = latency(producers, 20'000);
+        std::snprintf(name, sizeof name, "message_queue push to pop, %d producers", producers);
+        bench::report_latency(name, samples);
+    }
+}
@@ -0,0 +1,35 @@
+#include "bench.hpp"
+#include "lyn/multi_iterator.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Iterating over three vectors in lockstep with multi_iterator compared to
+// an indexed loop. Reported as ns per element.
+
+constexpr std::size_t elements = 1'000'000;
+constexpr int repetitions = 20;
+
+template<class Func>
+double ns_per_element(Func&& func) {
+    auto start = std::chrono::steady_clock::now();
+    for(int r = 0; r < repetitions; ++r) func();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (repetitions * static_cast<double>(elements));
+}
+
+int main() {
+    std::vector<int> a(elements), b(elements, 1), c(elements, 2);
+
+    bench::report_metrics("indexed loop, a[i] = b[i] + c[i]", {{"ns_per_element", ns_per_element([&] {
+                                                                     for(std::size_t i = 0; i < a.size(); ++i)
+                                                                         a[i] = b[i] + c[i];
+                                                                     bench::keep(a.data());
+                                                                 })}});
+    bench::report_metrics("multi_iterator, a = b + c", {{"ns_per_element", ns_per_element([&] {
+                                                              for(auto& [x, y, z] : lyn::multi_iterator(a, b, c))
+                                                                  x = y + z;
+                                                              bench::keep(a.data());
+                                                          })}});
+}
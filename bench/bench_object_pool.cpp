@@ -0,0 +1,101 @@
+#include "bench.hpp"
+#include "lyn/message_queue.hpp"
+#include "lyn/object_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Passing 1 KiB strings through a message_queue, constructed by the
+// producers and destroyed by the consumer, compared to recycling them
+// using an object_pool. Reported as ns and heap allocations per message,
+// counted after a warm up. At most 1024 messages are in flight.
+
+static std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+constexpr int messages = 1'000'000;
+constexpr int warm_up = 100'000;
+constexpr int max_in_flight = 1024;
+const std::string payload(1024, 'x');
+
+template<class C, class Make>
+void run(const char* name, int producers, Make&& make) {
+    lyn::mq::message_queue<C> mq;
+    std::atomic<int> in_flight{0};
+    std::atomic<int> produced{0};
+    std::size_t allocs_before = 0;
+    std::chrono::steady_clock::time_point start;
+
+    std::thread consumer([&] {
+        for(int i = 0; i < messages; ++i) {
+            if(i == warm_up) {
+                allocs_before = allocations.load();
+                start = std::chrono::steady_clock::now();
+            }
+            C msg = mq.pop();
+            bench::keep(msg);
+            in_flight.fetch_sub(1, std::memory_order_relaxed);
+        }
+    });
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            while(produced.fetch_add(1, std::memory_order_relaxed) < messages) {
+                while(in_flight.load(std::memory_order_relaxed) >= max_in_flight) std::this_thread::yield();
+                in_flight.fetch_add(1, std::memory_order_relaxed);
+                mq.push(make());
+            }
+        });
+    }
+    for(auto& th : threads) th.join();
+    consumer.join();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    double measured = messages - warm_up;
+    bench::report_metrics(name, {{"ns_per_op", elapsed.count() / measured},
+                                 {"allocations_per_op", static_cast<double>(allocations.load() - allocs_before) / measured}});
+}
+
+int main() {
+    char name[64];
+    for(int producers : {1, 4}) {
+        std::snprintf(name, sizeof name, "message_queue<std::string>, %d producers", producers);
+        run<std::string>(name, producers, [] { return std::string(payload); });
+
+        lyn::object_pool<std::string> pool;
+        std::snprintf(name, sizeof name, "message_queue<pool_handle<std::string>>, %d producers", producers);
+        run<lyn::pool_handle<std::string>>(name, producers, [&pool] {
+            auto handle = pool.acquire();
+            *handle = payload;
+            return handle;
+        });
+        std::snprintf(name, sizeof name, "  objects created by the pool, %d producers", producers);
+        bench::report_metrics(name, {{"objects", static_cast<double>(pool.size())}});
+    }
+
+    constexpr std::size_t iterations = 10'000'000;
+    bench::report("std::make_unique<std::string> + assign + delete", bench::ns_per_op(iterations, [](std::size_t) {
+                      auto ptr = std::make_unique<std::string>();
+                      *ptr = payload;
+                      bench::keep(ptr);
+                  }));
+    lyn::object_pool<std::string> pool;
+    bench::report("object_pool::acquire + assign + release", bench::ns_per_op(iterations, [&pool](std::size_t) {
+                      auto handle = pool.acquire();
+                      *handle = payload;
+                      bench::keep(handle);
+                  }));
+}
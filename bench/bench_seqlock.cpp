@@ -0,0 +1,91 @@
+#include "bench.hpp"
+#include "lyn/seqlock.hpp"
+#include "lyn/thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Read scalability of a published snapshot with 1-64 reader threads while
+// one writer updates it every 10 us: the mutex based helpers in thread.hpp
+// compared to seqlock (and triple_buffer, which has a single reader).
+// Reported as wall time per read, summed over all readers.
+
+struct snapshot {
+    std::uint64_t version;
+    std::uint64_t routes[6];
+};
+
+constexpr auto run_time = std::chrono::milliseconds(200);
+
+template<class Read, class Write>
+double run(int readers, Read&& read, Write&& write) {
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> total{0};
+    std::vector<std::thread> threads;
+    for(int r = 0; r < readers; ++r) {
+        threads.emplace_back([&] {
+            std::uint64_t reads = 0;
+            while(not stop.load(std::memory_order_relaxed)) {
+                bench::keep(read());
+                ++reads;
+            }
+            total += reads;
+        });
+    }
+    auto writer = std::thread([&] {
+        for(std::uint64_t v = 1; not stop.load(std::memory_order_relaxed); ++v) {
+            write(snapshot{v, {v, v, v, v, v, v}});
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+        }
+    });
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(run_time);
+    stop = true;
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    for(auto& th : threads) th.join();
+    writer.join();
+    return elapsed.count() / static_cast<double>(total.load());
+}
+
+int main() {
+    using lyn::thread::guard_then_notify_using;
+    char name[64];
+    for(int readers : {1, 2, 4, 8, 16, 32, 64}) {
+        {
+            lyn::thread::event<false> ev;
+            snapshot shared{};
+            auto read = [&] { return ev.synchronize([&] { return shared; }).version; };
+            auto write = [&](const snapshot& s) { ev.synchronize([&] { shared = s; }); };
+            std::snprintf(name, sizeof name, "event::synchronize, %d readers", readers);
+            bench::report(name, run(readers, read, write));
+        }
+        {
+            lyn::thread::cv_mtx_pair cvmtx;
+            snapshot shared{};
+            auto read = [&] {
+                return guard_then_notify_using<lyn::thread::notifier_of_none>(cvmtx, [&] { return shared; }).version;
+            };
+            auto write = [&](const snapshot& s) {
+                guard_then_notify_using<lyn::thread::notifier_of_all>(cvmtx, [&] { shared = s; });
+            };
+            std::snprintf(name, sizeof name, "guard_then_notify_using, %d readers", readers);
+            bench::report(name, run(readers, read, write));
+        }
+        {
+            lyn::thread::seqlock<snapshot> sl;
+            auto read = [&] { return sl.load().version; };
+            auto write = [&](const snapshot& s) { sl.store(s); };
+            std::snprintf(name, sizeof name, "seqlock, %d readers", readers);
+            bench::report(name, run(readers, read, write));
+        }
+        if(readers == 1) {
+            lyn::thread::triple_buffer<snapshot> tb;
+            auto read = [&] { return tb.read().version; };
+            auto write = [&](const snapshot& s) { tb.write(s); };
+            bench::report("triple_buffer, 1 reader", run(readers, read, write));
+        }
+    }
+}
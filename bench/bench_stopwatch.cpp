@@ -0,0 +1,53 @@
+#include "bench.hpp"
+#include "lyn/barrier.hpp"
+#include "lyn/stopwatch.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the cost of instrumenting code with scoped_timer / latency_histogram::record
+
+int main() {
+    constexpr std::size_t iterations = 10'000'000;
+
+    lyn::latency_histogram<std::chrono::nanoseconds> hist;
+    bench::report("latency_histogram::record", bench::ns_per_op(iterations, [&](std::size_t i) {
+                      hist.record(std::chrono::nanoseconds(i & 0xFFFF));
+                  }));
+    bench::report("scoped_timer", bench::ns_per_op(iterations, [&](std::size_t) { lyn::scoped_timer timer(hist); }));
+
+    for(unsigned threads : {2U, 4U, 8U}) {
+        std::vector<std::thread> ths;
+        auto start = std::chrono::steady_clock::now();
+        for(unsigned t = 0; t < threads; ++t) {
+            ths.emplace_back([&] {
+                for(std::size_t i = 0; i < iterations / threads; ++i) lyn::scoped_timer timer(hist);
+            });
+        }
+        for(auto& th : ths) th.join();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        auto name = "scoped_timer " + std::to_string(threads) + " threads (wall time)";
+        bench::report(name.c_str(), elapsed.count() / static_cast<double>(iterations));
+    }
+
+    // a histogram with exactly 4 shards, the threads stay alive until all
+    // have recorded so that no thread id is reused
+    lyn::latency_histogram<std::chrono::nanoseconds> four;
+    lyn::thread::latch recorded(4);
+    std::vector<std::thread> ths;
+    for(unsigned t = 0; t < 4; ++t) {
+        ths.emplace_back([&] {
+            for(std::size_t i = 0; i < 1000; ++i) four.record(std::chrono::nanoseconds(i));
+            recorded.arrive_and_wait();
+        });
+    }
+    for(auto& th : ths) th.join();
+
+    auto start = std::chrono::steady_clock::now();
+    auto snap = four.snapshot();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    bench::report("latency_histogram::snapshot (4 shards)", elapsed.count());
+    bench::keep(snap.count());
+}
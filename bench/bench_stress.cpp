@@ -0,0 +1,455 @@
+#include "bench.hpp"
+#include "lyn/abstract_thread.hpp"
+#include "lyn/message_queue.hpp"
+#include "lyn/thread.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Stress test of event<true>, event<false>, message_queue and
+// abstract_thread start / terminate cycles, reporting operations per second
+// and latency percentiles while checking that:
+//
+//   event<true>     every signal is consumed by exactly one waiter
+//   event<false>    every waiter wakes up in every round
+//   message_queue   every message is delivered exactly once and in order per producer
+//   abstract_thread setup_in_thread and execute run once per start
+//
+// The operations each thread performs are drawn from a random generator
+// seeded by --seed, so a run can be repeated with the same operation
+// sequences. A violated invariant makes the program exit with status 1. A
+// scenario not finishing within --timeout seconds, which is what a lost
+// wake-up looks like, makes it exit with status 2.
+//
+// usage: bench_stress [--threads N] [--ops N] [--seed N] [--blocking PERCENT] [--timeout SECONDS] [scenario...]
+//
+// scenarios: auto_reset manual_reset message_queue abstract_thread (all by default)
+// --blocking is the share of blocking waits and pops, the rest are polling
+
+using lyn::thread::event;
+
+struct options {
+    unsigned threads = 4;
+    unsigned ops = 20'000; // per thread
+    unsigned seed = 1;
+    unsigned blocking = 50;
+    unsigned timeout = 60;
+};
+
+options opts;
+std::atomic<unsigned> violations{0};
+
+void check(bool ok, const char* what) {
+    if(not ok && violations.fetch_add(1) < 10) std::fprintf(stderr, "invariant violated: %s\n", what);
+}
+
+std::int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// the operation sequence of thread number index in a scenario
+std::mt19937 make_rng(unsigned scenario, unsigned index) {
+    std::seed_seq seq{opts.seed, scenario, index};
+    return std::mt19937(seq);
+}
+
+bool blocking(std::mt19937& rng) { return rng() % 100 < opts.blocking; }
+
+// exits with status 2 unless destroyed within opts.timeout seconds
+class watchdog {
+public:
+    explicit watchdog(const char* scenario) :
+        m_th([this, scenario] {
+            if(not m_done.wait_for(std::chrono::seconds(opts.timeout))) {
+                std::fprintf(stderr, "%s: not done after %u seconds, lost wake-up?\n", scenario, opts.timeout);
+                std::_Exit(2);
+            }
+        }) {}
+    ~watchdog() {
+        m_done.set();
+        m_th.join();
+    }
+
+private:
+    event<false> m_done;
+    std::thread m_th;
+};
+
+std::vector<double> merge(std::vector<std::vector<double>>& parts) {
+    std::vector<double> res;
+    for(auto& part : parts) res.insert(res.end(), part.begin(), part.end());
+    return res;
+}
+
+// -----------------------------------------------------------------------------
+// Setters signal an auto reset event, sometimes waiting for the previous
+// signal to be consumed first, and waiters consume the signals.
+void auto_reset() {
+    watchdog wd("auto_reset");
+    unsigned setters = std::max(1U, opts.threads / 2), waiters = std::max(1U, opts.threads - setters);
+
+    event<true> ev;
+    // guarded by ev
+    bool signaled = false; // shadows the state of ev
+    bool done = false;
+    std::int64_t set_at = 0;
+    std::uint64_t sets = 0, coalesced = 0, consumed = 0;
+
+    std::vector<std::vector<double>> latencies(waiters);
+    std::vector<std::thread> threads;
+    auto start = now_ns();
+    for(unsigned w = 0; w < waiters; ++w) {
+        threads.emplace_back([&, w] {
+            auto rng = make_rng(1, setters + w);
+            bool last = false;
+            auto consume = [&] {
+                check(signaled, "event<true>: a signal was consumed twice");
+                signaled = false;
+                ++consumed;
+                latencies[w].push_back(static_cast<double>(now_ns() - set_at));
+                last = done;
+            };
+            while(not last) {
+                if(blocking(rng)) {
+                    ev.wait(consume);
+                } else if(not ev.try_wait(consume)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::vector<std::thread> setting;
+    for(unsigned s = 0; s < setters; ++s) {
+        setting.emplace_back([&, s] {
+            auto rng = make_rng(1, s);
+            for(unsigned i = 0; i < opts.ops; ++i) {
+                if(blocking(rng)) ev.wait_for_reset();
+                ev.set([&] {
+                    ++sets;
+                    if(signaled) {
+                        ++coalesced;
+                    } else {
+                        signaled = true;
+                        set_at = now_ns();
+                    }
+                });
+            }
+        });
+    }
+    for(auto& th : setting) th.join();
+
+    // one last signal per waiter, each one making a waiter return
+    for(unsigned w = 0; w < waiters; ++w) {
+        ev.wait_for_reset();
+        ev.set([&] {
+            ++sets;
+            signaled = true;
+            set_at = now_ns();
+            done = true;
+        });
+    }
+    for(auto& th : threads) th.join();
+    auto elapsed = static_cast<double>(now_ns() - start);
+
+    check(consumed == sets - coalesced, "event<true>: signals lost or consumed more than once");
+    check(not signaled, "event<true>: a signal was never consumed");
+
+    char name[64];
+    std::snprintf(name, sizeof name, "event<true>, %u setters, %u waiters", setters, waiters);
+    bench::report_metrics(name, {{"signals_per_s", static_cast<double>(consumed) / elapsed * 1e9},
+                                 {"coalesced", static_cast<double>(coalesced)}});
+    auto samples = merge(latencies);
+    std::snprintf(name, sizeof name, "event<true>, set to wake up");
+    bench::report_latency(name, samples);
+}
+
+// -----------------------------------------------------------------------------
+// A controller signals a manual reset event and waits for all waiters to
+// acknowledge it, then resets it and waits for all waiters to see the reset.
+void manual_reset() {
+    watchdog wd("manual_reset");
+    unsigned waiters = opts.threads;
+    unsigned rounds = opts.ops;
+
+    event<false> ev;
+    event<true> all_acked, all_reset;
+    std::atomic<unsigned> acks{0}, reset_acks{0};
+    std::uint64_t round = 0; // guarded by ev
+    std::int64_t set_at = 0; // guarded by ev
+
+    std::vector<std::vector<double>> latencies(waiters);
+    std::vector<std::thread> threads;
+    auto start = now_ns();
+    for(unsigned w = 0; w < waiters; ++w) {
+        threads.emplace_back([&, w] {
+            auto rng = make_rng(2, w);
+            for(std::uint64_t expected = 1; expected <= rounds; ++expected) {
+                auto observe = [&] {
+                    check(round == expected, "event<false>: a waiter missed a round");
+                    latencies[w].push_back(static_cast<double>(now_ns() - set_at));
+                };
+                if(blocking(rng)) {
+                    ev.wait(observe);
+                } else {
+                    while(not ev.try_wait(observe)) std::this_thread::yield();
+                }
+                if(acks.fetch_add(1) + 1 == waiters) all_acked.set();
+                ev.wait_for_reset();
+                if(reset_acks.fetch_add(1) + 1 == waiters) all_reset.set();
+            }
+        });
+    }
+    for(unsigned r = 0; r < rounds; ++r) {
+        ev.set([&] {
+            ++round;
+            set_at = now_ns();
+        });
+        all_acked.wait();
+        acks.store(0);
+        ev.reset();
+        all_reset.wait();
+        reset_acks.store(0);
+    }
+    for(auto& th : threads) th.join();
+    auto elapsed = static_cast<double>(now_ns() - start);
+
+    char name[64];
+    std::snprintf(name, sizeof name, "event<false>, %u waiters", waiters);
+    bench::report_metrics(name, {{"rounds_per_s", rounds / elapsed * 1e9},
+                                 {"wakeups_per_s", static_cast<double>(rounds) * waiters / elapsed * 1e9}});
+    auto samples = merge(latencies);
+    std::snprintf(name, sizeof name, "event<false>, set to wake up");
+    bench::report_latency(name, samples);
+}
+
+// -----------------------------------------------------------------------------
+// Producers push or emplace, consumers use a mix of the blocking and
+// polling pop functions.
+struct message {
+    message() = default;
+    message(unsigned p, unsigned s, std::int64_t t) : producer(p), seq(s), pushed_at(t) {}
+    unsigned producer = 0;
+    unsigned seq = 0;
+    std::int64_t pushed_at = 0;
+};
+
+void message_queue() {
+    watchdog wd("message_queue");
+    unsigned producers = std::max(1U, opts.threads / 2), consumers = std::max(1U, opts.threads - producers);
+    std::uint64_t total = std::uint64_t(producers) * opts.ops;
+
+    lyn::mq::message_queue<message> mq;
+    std::vector<std::unique_ptr<std::atomic<bool>[]>> delivered;
+    for(unsigned p = 0; p < producers; ++p) delivered.emplace_back(new std::atomic<bool>[opts.ops]{});
+    std::atomic<std::uint64_t> consumed{0};
+
+    std::vector<std::vector<double>> latencies(consumers);
+    std::vector<std::thread> threads;
+    auto start = now_ns();
+    for(unsigned c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c] {
+            auto rng = make_rng(3, producers + c);
+            std::vector<std::int64_t> last_seq(producers, -1);
+            auto process = [&](const message& msg) {
+                latencies[c].push_back(static_cast<double>(now_ns() - msg.pushed_at));
+                check(not delivered[msg.producer][msg.seq].exchange(true), "message_queue: a message was delivered twice");
+                check(msg.seq > last_seq[msg.producer], "message_queue: messages from a producer were reordered");
+                last_seq[msg.producer] = msg.seq;
+                if(consumed.fetch_add(1) + 1 == total) mq.shutdown();
+            };
+            try {
+                while(true) {
+                    auto op = rng() % 100;
+                    if(op < opts.blocking) {
+                        process(mq.pop());
+                    } else if(op % 2) {
+                        message msg;
+                        if(mq.pop(msg))
+                            process(msg);
+                        else
+                            std::this_thread::yield();
+                    } else {
+                        lyn::mq::message_queue<message>::queue_t queue;
+                        if(mq.pop_all(queue)) {
+                            for(; not queue.empty(); queue.pop()) process(queue.front());
+                        } else {
+                            std::this_thread::yield();
+                        }
+                    }
+                }
+            } catch(const lyn::mq::message_queue_exception&) {
+                // shut down after the last message
+            }
+        });
+    }
+    std::vector<std::thread> producing;
+    for(unsigned p = 0; p < producers; ++p) {
+        producing.emplace_back([&, p] {
+            auto rng = make_rng(3, p);
+            for(unsigned i = 0; i < opts.ops; ++i) {
+                if(rng() % 2)
+                    mq.push(message(p, i, now_ns()));
+                else
+                    mq.emplace(p, i, now_ns());
+            }
+        });
+    }
+    for(auto& th : producing) th.join();
+    for(auto& th : threads) th.join();
+    auto elapsed = static_cast<double>(now_ns() - start);
+
+    check(consumed == total, "message_queue: messages lost");
+    for(unsigned p = 0; p < producers; ++p) {
+        for(unsigned i = 0; i < opts.ops; ++i) check(delivered[p][i], "message_queue: a message was never delivered");
+    }
+
+    char name[64];
+    std::snprintf(name, sizeof name, "message_queue, %u producers, %u consumers", producers, consumers);
+    bench::report_metrics(name, {{"messages_per_s", static_cast<double>(total) / elapsed * 1e9}});
+    auto samples = merge(latencies);
+    std::snprintf(name, sizeof name, "message_queue, push to pop");
+    bench::report_latency(name, samples);
+}
+
+// -----------------------------------------------------------------------------
+// Every thread starts and stops its own worker over and over, handing it
+// a few jobs in between.
+class worker final : public lyn::thread::abstract_thread {
+public:
+    ~worker() override { shutdown(); }
+
+    void shutdown() {
+        terminate();
+        m_work.set();
+        join();
+    }
+
+    // hands the worker a job and waits for it to be done
+    void job() {
+        m_work.set();
+        m_done.wait();
+    }
+
+    unsigned setups = 0, executions = 0, jobs = 0;
+
+private:
+    void setup_in_thread() override {
+        ++setups;
+        m_setup_done = true;
+    }
+    void execute() override {
+        check(m_setup_done, "abstract_thread: execute without setup_in_thread");
+        m_setup_done = false;
+        ++executions;
+        while(true) {
+            m_work.wait();
+            if(terminated()) break;
+            ++jobs;
+            m_done.set();
+        }
+    }
+
+    bool m_setup_done = false;
+    event<true> m_work, m_done;
+};
+
+void abstract_thread() {
+    watchdog wd("abstract_thread");
+    unsigned cycles = std::max(1U, opts.ops / 20);
+
+    std::vector<std::vector<double>> start_latencies(opts.threads), stop_latencies(opts.threads);
+    std::vector<std::thread> threads;
+    auto start = now_ns();
+    for(unsigned t = 0; t < opts.threads; ++t) {
+        threads.emplace_back([&, t] {
+            auto rng = make_rng(4, t);
+            worker w;
+            unsigned jobs = 0;
+            for(unsigned c = 0; c < cycles; ++c) {
+                auto before = now_ns();
+                w.start();
+                auto started = now_ns();
+                for(auto n = rng() % 4; n; --n, ++jobs) w.job();
+                auto stopping = now_ns();
+                w.shutdown();
+                start_latencies[t].push_back(static_cast<double>(started - before));
+                stop_latencies[t].push_back(static_cast<double>(now_ns() - stopping));
+            }
+            check(w.setups == cycles, "abstract_thread: setup_in_thread did not run once per start");
+            check(w.executions == cycles, "abstract_thread: execute did not run once per start");
+            check(w.jobs == jobs, "abstract_thread: jobs lost");
+        });
+    }
+    for(auto& th : threads) th.join();
+    auto elapsed = static_cast<double>(now_ns() - start);
+
+    char name[64];
+    std::snprintf(name, sizeof name, "abstract_thread start / terminate, %u threads", opts.threads);
+    bench::report_metrics(name, {{"cycles_per_s", static_cast<double>(cycles) * opts.threads / elapsed * 1e9}});
+    auto samples = merge(start_latencies);
+    bench::report_latency("abstract_thread::start", samples);
+    samples = merge(stop_latencies);
+    bench::report_latency("abstract_thread terminate and join", samples);
+}
+
+// -----------------------------------------------------------------------------
+int main(int argc, char* argv[]) {
+    struct scenario {
+        const char* name;
+        void (*run)();
+        bool selected;
+    } scenarios[] = {{"auto_reset", auto_reset, false},
+                     {"manual_reset", manual_reset, false},
+                     {"message_queue", message_queue, false},
+                     {"abstract_thread", abstract_thread, false}};
+    bool any = false;
+
+    for(int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        unsigned* value = arg == "--threads"    ? &opts.threads
+                          : arg == "--ops"      ? &opts.ops
+                          : arg == "--seed"     ? &opts.seed
+                          : arg == "--blocking" ? &opts.blocking
+                          : arg == "--timeout"  ? &opts.timeout
+                                                : nullptr;
+        if(value && i + 1 < argc) {
+            *value = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            continue;
+        }
+        auto it = std::find_if(std::begin(scenarios), std::end(scenarios),
+                               [&](const scenario& s) { return arg == s.name; });
+        if(it == std::end(scenarios)) {
+            std::fprintf(stderr,
+                         "usage: %s [--threads N] [--ops N] [--seed N] [--blocking PERCENT] [--timeout SECONDS] "
+                         "[auto_reset] [manual_reset] [message_queue] [abstract_thread]\n",
+                         argv[0]);
+            return 1;
+        }
+        it->selected = any = true;
+    }
+    if(opts.threads == 0 || opts.ops == 0 || opts.blocking > 100) {
+        std::fprintf(stderr, "%s: --threads and --ops must be > 0 and --blocking <= 100\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("seed %u, %u threads, %u operations per thread, %u%% blocking\n", opts.seed, opts.threads, opts.ops,
+                opts.blocking);
+    for(auto& s : scenarios) {
+        if(s.selected || not any) s.run();
+    }
+    if(violations) {
+        std::fprintf(stderr, "%u invariant violations\n", violations.load());
+        return 1;
+    }
+}
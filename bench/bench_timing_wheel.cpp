@@ -0,0 +1,70 @@
+#include "bench.hpp"
+#include "lyn/timing_wheel.hpp"
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// schedule and cancel with 10M pending timers: timing_wheel compared to a
+// mutex protected std::multimap, which is how timers are usually kept (and
+// how the event awaitables' timeouts are kept).
+
+constexpr std::size_t pending_timers = 10'000'000;
+constexpr std::size_t operations = 2'000'000;
+
+using namespace std::chrono_literals;
+
+struct multimap_timers {
+    using map_type = std::multimap<std::chrono::steady_clock::time_point, std::function<void()>>;
+
+    map_type::iterator schedule_at(std::chrono::steady_clock::time_point tp, std::function<void()> func) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return timers.emplace(tp, std::move(func));
+    }
+    void cancel(map_type::iterator it) {
+        std::lock_guard<std::mutex> lock(mtx);
+        timers.erase(it);
+    }
+
+    std::mutex mtx;
+    map_type timers;
+};
+
+template<class Timers>
+void run(const char* name, Timers& timers) {
+    auto now = std::chrono::steady_clock::now();
+    // spread the pending timers over the next hour
+    auto fill = bench::ns_per_op(pending_timers, [&](std::size_t i) {
+        timers.schedule_at(now + 1h + std::chrono::microseconds(i * 360), [] {});
+    });
+    std::printf("%s\n", name);
+    bench::report("  schedule, filling up to 10M pending", fill);
+
+    using id_type = decltype(timers.schedule_at(now, [] {}));
+    std::vector<id_type> ids;
+    ids.reserve(operations);
+    auto sched = bench::ns_per_op(operations, [&](std::size_t i) {
+        ids.push_back(timers.schedule_at(now + 30min + std::chrono::microseconds(i), [] {}));
+    });
+    bench::report("  schedule, 10M pending", sched);
+    auto cancel = bench::ns_per_op(operations, [&](std::size_t i) { timers.cancel(ids[i]); });
+    bench::report("  cancel, 10M pending", cancel);
+    auto pair = bench::ns_per_op(operations, [&](std::size_t i) {
+        timers.cancel(timers.schedule_at(now + 30min + std::chrono::microseconds(i), [] {}));
+    });
+    bench::report("  schedule + cancel, 10M pending", pair);
+}
+
+int main() {
+    {
+        lyn::thread::timing_wheel<> wheel;
+        wheel.start();
+        run("timing_wheel", wheel);
+    }
+    {
+        multimap_timers timers;
+        run("mutex + std::multimap", timers);
+    }
+}
@@ -0,0 +1,41 @@
+// Compiled, not run, by bench_compile_seq with LYN_SEQ_N set to the length
+// of the sequence and LYN_SEQ_OP to the operation to instantiate.
+
+#include "lyn/utility.hpp"
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace baseline {
+    // the previous reverse_sequence, indexing a std::tuple with every value
+    template<class T, T... I, std::size_t... J>
+    constexpr auto rev_helper(std::integer_sequence<T, I...>, std::index_sequence<J...>) {
+        return std::integer_sequence<T, std::get<sizeof...(J) - J - 1>(std::tuple<decltype(I)...>{I...})...>{};
+    }
+    template<class T, T... I>
+    constexpr auto reverse_sequence(std::integer_sequence<T, I...> s) {
+        return rev_helper(s, std::make_index_sequence<sizeof...(I)>{});
+    }
+} // namespace baseline
+
+struct is_odd {
+    constexpr bool operator()(int v) const { return v % 2 != 0; }
+};
+
+using input = lyn::seq::make_integer_range<int, 0, LYN_SEQ_N>;
+using reversed = lyn::seq::make_integer_range<int, LYN_SEQ_N - 1, -1, -1>;
+
+#if LYN_SEQ_OP == 0
+static_assert(std::is_same<decltype(baseline::reverse_sequence(input{})), reversed>::value, "");
+#elif LYN_SEQ_OP == 1
+static_assert(std::is_same<lyn::seq::reverse_t<input>, reversed>::value, "");
+#elif LYN_SEQ_OP == 2
+static_assert(lyn::seq::concat_t<input, input, input, input>::size() == 4 * LYN_SEQ_N, "");
+#elif LYN_SEQ_OP == 3
+static_assert(lyn::seq::slice_t<input, LYN_SEQ_N / 4, LYN_SEQ_N / 2>::size() == LYN_SEQ_N / 4, "");
+#elif LYN_SEQ_OP == 4
+static_assert(lyn::seq::filter_t<input, is_odd>::size() == LYN_SEQ_N / 2, "");
+#elif LYN_SEQ_OP == 5
+static_assert(std::is_same<lyn::seq::sort_t<reversed>, input>::value, "");
+#endif
@@ -0,0 +1,32 @@
+#include "lyn/clock.hpp"
+#include "lyn/log_watch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+// log_watch using the clock adapters
+
+int main() {
+    using namespace std::chrono;
+
+    lyn::log_watch<nanoseconds> sys_lw("%FT%T.");
+    std::cout << "system_clock        " << sys_lw(system_clock::now()) << '\n';
+
+#ifdef LYN_HAS_COARSE_SYSTEM_CLOCK
+    lyn::log_watch<milliseconds, lyn::chrono::coarse_system_clock> coarse_lw("%FT%T.");
+    std::cout << "coarse_system_clock " << coarse_lw(lyn::chrono::coarse_system_clock::now()) << " (resolution "
+              << lyn::chrono::coarse_system_clock::resolution().count() << " ns)\n";
+#endif
+
+#ifdef LYN_HAS_TSC_CLOCK
+    lyn::chrono::tsc_clock::calibrate();
+    lyn::log_watch<nanoseconds, lyn::chrono::tsc_clock> tsc_lw("%FT%T.");
+    std::cout << "tsc_clock           " << tsc_lw(lyn::chrono::tsc_clock::now())
+              << (lyn::chrono::tsc_clock::is_invariant() ? " (invariant)\n" : " (NOT invariant)\n");
+#endif
+
+    lyn::chrono::cached_clock<>::updater upd(milliseconds(1));
+    upd.start();
+    lyn::log_watch<milliseconds, lyn::chrono::cached_clock<>> cached_lw("%FT%T.");
+    std::cout << "cached_clock        " << cached_lw(lyn::chrono::cached_clock<>::now()) << '\n';
+}
@@ -0,0 +1,342 @@
+#pragma once
+
+/*
+ * lyn::async_logger
+ * Takes the time stamp and captures the arguments in the calling thread and
+ * leaves formatting (using lyn::log_watch) and writing to a background thread.
+ */
+
+#include "lyn/abstract_thread.hpp"
+#include "lyn/log_watch.hpp"
+#include "lyn/message_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace lyn {
+
+// what async_logger::log does when all preallocated records are in use
+enum class overflow_policy {
+    block, // wait for the background thread to release a record
+    drop   // discard the message, count it and return false
+};
+
+namespace detail {
+    // Strings are copied into the record since the caller's buffer may be
+    // gone by the time the background thread formats the message. The bytes
+    // go into the part of the record's storage after the arguments and the
+    // arguments keep where they are.
+    struct captured_string {
+        std::uint32_t offset; // in the string area
+        std::uint32_t size;
+    };
+
+    template<class T>
+    inline constexpr bool is_string_arg_v = std::is_convertible_v<const std::decay_t<T>&, std::string_view>;
+
+    template<class T>
+    using captured_arg_t = std::conditional_t<is_string_arg_v<T>, captured_string, std::decay_t<T>>;
+
+    // the string area of a record being filled in
+    class string_area {
+    public:
+        string_area(unsigned char* data, std::size_t capacity) : m_data(data), m_capacity(capacity) {}
+
+        // copies as much of str as fits
+        captured_string add(std::string_view str) noexcept {
+            auto size = std::min(str.size(), m_capacity - m_used);
+            if(size < str.size()) m_truncated = true;
+            std::memcpy(m_data + m_used, str.data(), size);
+            captured_string res{static_cast<std::uint32_t>(m_used), static_cast<std::uint32_t>(size)};
+            m_used += size;
+            return res;
+        }
+        inline bool truncated() const noexcept { return m_truncated; }
+
+    private:
+        unsigned char* m_data;
+        std::size_t m_capacity;
+        std::size_t m_used = 0;
+        bool m_truncated = false;
+    };
+
+    template<class T>
+    captured_arg_t<T> capture_arg(T&& value, string_area& area) {
+        using D = std::decay_t<T>;
+        if constexpr(std::is_pointer_v<D> && not std::is_array_v<std::remove_reference_t<T>> && is_string_arg_v<T>) {
+            return area.add(value ? std::string_view(value) : std::string_view("(null)"));
+        } else if constexpr(is_string_arg_v<T>) {
+            return area.add(std::string_view(value));
+        } else {
+            return std::forward<T>(value);
+        }
+    }
+
+    // appends value to out, like operator<< would, but avoids streams for
+    // the common types
+    template<class T>
+    void append_arg(std::string& out, const T& value) {
+        if constexpr(std::is_same_v<T, char>) {
+            out.push_back(value);
+        } else if constexpr(std::is_same_v<T, bool>) {
+            out.push_back(value ? '1' : '0');
+        } else if constexpr(std::is_convertible_v<const T&, std::string_view>) {
+            out.append(std::string_view(value));
+        } else if constexpr(std::is_arithmetic_v<T>) {
+            char buf[64];
+            auto res = std::to_chars(buf, buf + sizeof buf, value);
+            out.append(buf, res.ptr);
+        } else {
+            std::ostringstream oss;
+            oss << value;
+            out.append(oss.str());
+        }
+    }
+
+    template<class T>
+    inline void append_captured(std::string& out, const T& value, const unsigned char*) {
+        append_arg(out, value);
+    }
+    inline void append_captured(std::string& out, const captured_string& str, const unsigned char* strings) {
+        out.append(reinterpret_cast<const char*>(strings) + str.offset, str.size);
+    }
+} // namespace detail
+
+// Messages are captured in a fixed number of preallocated records, each with
+// room for ArgBytes bytes of decayed arguments. Arguments are stored by
+// value. The characters of strings, including const char* and
+// std::string_view, are copied into the same ArgBytes bytes, after the other
+// arguments, so log() doesn't allocate. Strings that don't fit are
+// truncated, counted and reported like dropped messages.
+//
+// shutdown(), which is called by the destructor, writes all messages logged
+// before it returns. A log call that has not returned before shutdown() is
+// called either returns false or gets its message written.
+template<class Precision = std::chrono::microseconds, class Clock = std::chrono::system_clock,
+         std::size_t ArgBytes = 256>
+class async_logger final : public lyn::thread::abstract_thread {
+public:
+    using log_watch_type = log_watch<Precision, Clock>;
+    using time_point = typename log_watch_type::time_point;
+
+    explicit async_logger(int fd = STDOUT_FILENO, std::size_t capacity = 4096,
+                          overflow_policy policy = overflow_policy::block, const std::string& format = "%FT%T.",
+                          std::size_t buffer_size = 64 * 1024) :
+        m_fd(fd),
+        m_policy(policy), m_buffer_size(buffer_size), m_lw(format), m_records(capacity) {
+        for(auto& rec : m_records) m_free.push(&rec);
+    }
+    ~async_logger() override { shutdown(); }
+
+    // throws if the logger has been shut down
+    void start() override {
+        std::lock_guard<std::mutex> lock(m_start_mtx);
+        if(not m_open) throw std::runtime_error("async_logger: start after shutdown");
+        abstract_thread::start();
+    }
+
+    template<class... Args>
+    inline bool log(Args&&... args) {
+        return log_at(Clock::now(), std::forward<Args>(args)...);
+    }
+
+    // returns false if the message was dropped
+    template<class... Args>
+    bool log_at(time_point tp, Args&&... args) {
+        using tuple_type = std::tuple<detail::captured_arg_t<Args>...>;
+        static_assert(sizeof(tuple_type) <= ArgBytes, "arguments too large for a record, increase ArgBytes");
+        static_assert(alignof(tuple_type) <= alignof(std::max_align_t), "over-aligned argument");
+
+        // shutdown() waits for the producers that got past m_open
+        producer_guard guard(m_producers);
+        if(not m_open) return false;
+
+        record* rec;
+        if(m_policy == overflow_policy::drop) {
+            if(not m_free.pop(rec)) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } else if(not m_free.pop(rec)) {
+            rec = wait_for_record();
+        }
+
+        rec->tp = tp;
+        detail::string_area strings(rec->storage + sizeof(tuple_type), ArgBytes - sizeof(tuple_type));
+        try {
+            ::new(static_cast<void*>(rec->storage))
+                tuple_type(detail::capture_arg(std::forward<Args>(args), strings)...);
+        } catch(...) {
+            m_free.push(rec);
+            throw;
+        }
+        if(strings.truncated()) m_truncated.fetch_add(1, std::memory_order_relaxed);
+        rec->format = [](record& r, std::string& out) {
+            auto& args = *std::launder(reinterpret_cast<tuple_type*>(r.storage));
+            const unsigned char* strs = r.storage + sizeof(tuple_type);
+            std::apply([&out, strs](const auto&... a) { (..., detail::append_captured(out, a, strs)); }, args);
+            args.~tuple_type();
+        };
+        m_pending.push(rec);
+        return true;
+    }
+
+    // Stops accepting messages and returns when all messages logged before
+    // the call have been written. If start() has not been called, the
+    // messages are written by the calling thread, as they are by log() with
+    // the block policy when all records are in use.
+    void shutdown() {
+        if(m_open.exchange(false)) {
+            while(m_producers.load()) std::this_thread::yield();
+            m_pending.push(nullptr);
+            if(joinable())
+                join();
+            else
+                execute();
+        }
+    }
+
+    // the number of messages dropped by the drop overflow_policy
+    inline std::size_t dropped() const { return m_dropped_total.load(std::memory_order_relaxed); }
+
+    // the number of messages with strings truncated to fit in ArgBytes
+    inline std::size_t truncated() const { return m_truncated_total.load(std::memory_order_relaxed); }
+
+protected:
+    void execute() override {
+        std::string buffer;
+        buffer.reserve(m_buffer_size + 4096);
+
+        for(bool running = true; running;) {
+            auto batch = m_pending.pop_all();
+            running = write_batch(batch, buffer);
+        }
+    }
+
+private:
+    struct producer_guard {
+        explicit producer_guard(std::atomic<std::size_t>& count) : m_count(count) { m_count.fetch_add(1); }
+        producer_guard(const producer_guard&) = delete;            // no copies
+        producer_guard& operator=(const producer_guard&) = delete; // no copies
+        ~producer_guard() { m_count.fetch_sub(1); }
+        std::atomic<std::size_t>& m_count;
+    };
+
+    struct record {
+        time_point tp;
+        void (*format)(record&, std::string&); // formats and destroys the arguments
+        alignas(std::max_align_t) unsigned char storage[ArgBytes];
+    };
+    using record_queue = lyn::mq::message_queue<record*>;
+
+    // The block policy with all records in use. Until start() has been
+    // called, nothing else releases records so the calling thread writes the
+    // pending messages itself.
+    record* wait_for_record() {
+        record* rec;
+        while(true) {
+            {
+                std::lock_guard<std::mutex> lock(m_start_mtx);
+                if(joinable()) break;
+                typename record_queue::queue_t batch;
+                if(m_pending.pop_all(batch)) {
+                    std::string buffer;
+                    write_batch(batch, buffer);
+                }
+            }
+            if(m_free.pop(rec)) return rec;
+            std::this_thread::yield(); // other producers took them
+        }
+        return m_free.pop();
+    }
+
+    // formats and writes the records, returns false if the shutdown sentinel was seen
+    bool write_batch(typename record_queue::queue_t& batch, std::string& buffer) {
+        bool running = true;
+        for(; not batch.empty(); batch.pop()) {
+            record* rec = batch.front();
+            if(rec == nullptr) { // shutdown sentinel
+                running = false;
+                continue;
+            }
+            format_record(*rec, buffer);
+            m_free.push(rec);
+            if(buffer.size() >= m_buffer_size) write_all(buffer);
+        }
+        if(auto dropped = m_dropped.exchange(0, std::memory_order_relaxed)) {
+            m_dropped_total.fetch_add(dropped, std::memory_order_relaxed);
+            buffer += "async_logger: ";
+            detail::append_arg(buffer, dropped);
+            buffer += " messages dropped\n";
+        }
+        if(auto truncated = m_truncated.exchange(0, std::memory_order_relaxed)) {
+            m_truncated_total.fetch_add(truncated, std::memory_order_relaxed);
+            buffer += "async_logger: ";
+            detail::append_arg(buffer, truncated);
+            buffer += " messages truncated\n";
+        }
+        write_all(buffer);
+        return running;
+    }
+
+    void format_record(record& rec, std::string& out) {
+        static constexpr std::size_t max_time_len = 128;
+        auto pos = out.size();
+        out.resize(pos + max_time_len);
+        out.resize(pos + m_lw(rec.tp).format_to(out.data() + pos, max_time_len));
+        out.push_back(' ');
+        rec.format(rec, out);
+        out.push_back('\n');
+    }
+
+    void write_all(std::string& buffer) {
+        const char* data = buffer.data();
+        std::size_t left = buffer.size();
+        while(left) {
+            auto written = ::write(m_fd, data, left);
+            if(written < 0) {
+                if(errno == EINTR) continue;
+                break; // nowhere to report it
+            }
+            data += written;
+            left -= static_cast<std::size_t>(written);
+        }
+        buffer.clear();
+    }
+
+    std::atomic<bool> m_open{true};
+    std::atomic<std::size_t> m_producers{}; // log_at calls in progress
+    std::atomic<std::size_t> m_dropped{};
+    std::atomic<std::size_t> m_dropped_total{};
+    std::atomic<std::size_t> m_truncated{};
+    std::atomic<std::size_t> m_truncated_total{};
+    int m_fd;
+    overflow_policy m_policy;
+    std::size_t m_buffer_size;
+    log_watch_type m_lw;
+    std::vector<record> m_records;
+    record_queue m_free;
+    record_queue m_pending;
+    std::mutex m_start_mtx; // orders start() and writing in wait_for_record()
+};
+
+} // namespace lyn
@@ -0,0 +1,232 @@
+#pragma once
+
+/*
+ * lyn::thread::latch, lyn::thread::barrier and lyn::thread::combining_barrier
+ * Arrival is a single atomic operation. Waiting threads spin briefly and then
+ * sleep until the last thread to arrive has run the completion functor,
+ * which is invoked while the mutex used for sleeping is locked, like the
+ * functor given to event::set.
+ */
+
+#include "lyn/thread.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace lyn {
+namespace thread {
+    // the default completion functor of barrier and combining_barrier
+    struct no_completion {
+        void operator()() const noexcept {}
+    };
+
+    // -------------------------------------------------------------------------
+    /**
+     * \brief A single use countdown that threads can wait for to reach zero
+     */
+    class latch {
+    public:
+        explicit latch(std::ptrdiff_t count) : m_count(count), m_released(count == 0) {}
+        latch(const latch&) = delete;            // no copies
+        latch& operator=(const latch&) = delete; // no copies
+
+        /**
+         * \brief Decrease the count
+         *
+         * \param[in] The number to decrease the count by
+         * \param[in] An optional functor to invoke, while the latch is locked,
+         *            if this call brings the count to zero. It is invoked
+         *            before any waiting thread is released.
+         *
+         * \return bool : true if this call released the latch
+         */
+        template<class Func = void (*)()>
+        bool count_down(std::ptrdiff_t n = 1, Func&& func = [] {}) {
+            if(m_count.fetch_sub(n, std::memory_order_acq_rel) != n) return false;
+            guard_then_notify_using<notifier_of_all>(m_cvmtx, [&] {
+                func();
+                m_released.store(true, std::memory_order_release);
+            });
+            return true;
+        }
+
+        // true if the latch has been released
+        inline bool try_wait() const noexcept { return m_released.load(std::memory_order_acquire); }
+
+        void wait() {
+            detail::spin_then_wait(m_cvmtx, [this] { return try_wait(); });
+        }
+
+        template<class Func = void (*)()>
+        void arrive_and_wait(std::ptrdiff_t n = 1, Func&& func = [] {}) {
+            count_down(n, std::forward<Func>(func));
+            wait();
+        }
+
+    private:
+        std::atomic<std::ptrdiff_t> m_count;
+        std::atomic<bool> m_released;
+        cv_mtx_pair m_cvmtx;
+    };
+
+    // -------------------------------------------------------------------------
+    /**
+     * \brief A reusable barrier for a fixed number of participating threads
+     *
+     * The phase and the number of threads yet to arrive share one atomic
+     * word. The thread arriving last in a phase invokes the completion
+     * functor, while the barrier is locked, and then starts the next phase.
+     */
+    template<class Completion = no_completion>
+    class barrier {
+    public:
+        // returned by arrive() and given to wait()
+        class arrival_token {
+        public:
+            arrival_token(arrival_token&&) = default;
+            arrival_token& operator=(arrival_token&&) = default;
+
+        private:
+            friend class barrier;
+            explicit arrival_token(std::uint32_t phase) : m_phase(phase) {}
+            std::uint32_t m_phase;
+        };
+
+        explicit barrier(std::uint32_t expected, Completion completion = Completion{}) :
+            m_state(expected), m_expected(expected), m_completion(std::move(completion)) {}
+        barrier(const barrier&) = delete;            // no copies
+        barrier& operator=(const barrier&) = delete; // no copies
+
+        arrival_token arrive(std::uint32_t n = 1) {
+            auto state = m_state.fetch_sub(n, std::memory_order_acq_rel);
+            auto phase = static_cast<std::uint32_t>(state >> 32);
+            if(static_cast<std::uint32_t>(state) == n) complete(phase);
+            return arrival_token(phase);
+        }
+
+        void wait(arrival_token&& token) {
+            detail::spin_then_wait(m_cvmtx, [&] { return phase() != token.m_phase; });
+        }
+
+        void arrive_and_wait() { wait(arrive()); }
+
+        // arrive and don't participate in any of the following phases
+        void arrive_and_drop() {
+            m_expected.fetch_sub(1, std::memory_order_relaxed);
+            arrive();
+        }
+
+    private:
+        inline std::uint32_t phase() const noexcept {
+            return static_cast<std::uint32_t>(m_state.load(std::memory_order_acquire) >> 32);
+        }
+
+        void complete(std::uint32_t phase) {
+            guard_then_notify_using<notifier_of_all>(m_cvmtx, [&] {
+                m_completion();
+                m_state.store(std::uint64_t(phase + 1) << 32 | m_expected.load(std::memory_order_relaxed),
+                              std::memory_order_release);
+            });
+        }
+
+        std::atomic<std::uint64_t> m_state; // phase << 32 | threads yet to arrive
+        std::atomic<std::uint32_t> m_expected;
+        Completion m_completion;
+        cv_mtx_pair m_cvmtx;
+    };
+
+    // -------------------------------------------------------------------------
+    /**
+     * \brief A reusable barrier using a combining tree for large numbers of
+     *        participating threads
+     *
+     * Every participant has an index in [0, participants) and arrives at a
+     * leaf shared with at most fan_in - 1 other participants. The last to
+     * arrive at a node continues to its parent, so no counter is touched by
+     * more than fan_in threads per phase. The thread arriving last at the
+     * root invokes the completion functor, while the barrier is locked.
+     */
+    template<class Completion = no_completion>
+    class combining_barrier {
+    public:
+        explicit combining_barrier(std::size_t participants, Completion completion = Completion{},
+                                   std::size_t fan_in = 4) :
+            m_participants(participants),
+            m_fan_in(fan_in), m_completion(std::move(completion)) {
+            if(participants == 0 || fan_in < 2) throw std::invalid_argument("combining_barrier: invalid arguments");
+
+            // build the tree level by level, leaves first, root last
+            std::vector<std::size_t> counts;
+            for(std::size_t n = participants; counts.empty() || counts.size() - m_level_begin.back() > 1;) {
+                m_level_begin.push_back(counts.size());
+                for(std::size_t i = 0; i < n; i += fan_in) counts.push_back(std::min(fan_in, n - i));
+                n = counts.size() - m_level_begin.back();
+            }
+            m_nodes = std::vector<node>(counts.size());
+            for(std::size_t i = 0; i < counts.size(); ++i) {
+                m_nodes[i].count.store(static_cast<std::ptrdiff_t>(counts[i]), std::memory_order_relaxed);
+                m_nodes[i].expected.store(static_cast<std::ptrdiff_t>(counts[i]), std::memory_order_relaxed);
+            }
+        }
+        combining_barrier(const combining_barrier&) = delete;            // no copies
+        combining_barrier& operator=(const combining_barrier&) = delete; // no copies
+
+        inline std::size_t participants() const noexcept { return m_participants; }
+
+        void arrive_and_wait(std::size_t participant) {
+            auto ph = phase();
+            arrive(participant);
+            detail::spin_then_wait(m_cvmtx, [&] { return phase() != ph; });
+        }
+
+        // arrive and don't participate in any of the following phases
+        void arrive_and_drop(std::size_t participant) {
+            // a node without participants left is dropped from its parent
+            std::size_t level = 0;
+            std::size_t index = participant / m_fan_in;
+            while(m_nodes[m_level_begin[level] + index].expected.fetch_sub(1, std::memory_order_relaxed) == 1 &&
+                  level + 1 < m_level_begin.size()) {
+                ++level;
+                index /= m_fan_in;
+            }
+            arrive(participant);
+        }
+
+    private:
+        struct alignas(64) node {
+            std::atomic<std::ptrdiff_t> count{};
+            std::atomic<std::ptrdiff_t> expected{};
+        };
+
+        inline std::uint32_t phase() const noexcept { return m_phase.load(std::memory_order_acquire); }
+
+        void arrive(std::size_t participant) {
+            std::size_t index = participant / m_fan_in;
+            for(std::size_t level = 0; level < m_level_begin.size(); ++level, index /= m_fan_in) {
+                node& n = m_nodes[m_level_begin[level] + index];
+                if(n.count.fetch_sub(1, std::memory_order_acq_rel) != 1) return; // not last, done
+                // Last to arrive: rearm the node for the next phase. No one
+                // can arrive at it again before this phase is completed.
+                n.count.store(n.expected.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            guard_then_notify_using<notifier_of_all>(m_cvmtx, [&] {
+                m_completion();
+                m_phase.fetch_add(1, std::memory_order_release);
+            });
+        }
+
+        std::size_t m_participants;
+        std::size_t m_fan_in;
+        std::vector<std::size_t> m_level_begin; // the index in m_nodes of the first node of every level
+        std::vector<node> m_nodes;
+        std::atomic<std::uint32_t> m_phase{0};
+        Completion m_completion;
+        cv_mtx_pair m_cvmtx;
+    };
+} // namespace thread
+} // namespace lyn
@@ -0,0 +1,345 @@
+#pragma once
+
+/*
+ * lyn::mq::broadcast_queue
+ * A single producer, multiple subscriber ring buffer where every subscriber
+ * sees every message. Messages are stored once and read in place.
+ *
+ * Requires C++17
+ */
+
+#include "lyn/message_queue.hpp"
+#include "lyn/thread.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lyn {
+namespace mq {
+    // what push() does when the oldest message in the ring has not been read
+    // by all subscribers
+    enum class slow_subscriber_policy {
+        block, // wait for the slowest subscriber
+        drop   // overwrite it, the slow subscribers get a gap
+    };
+
+    template<class C>
+    class broadcast_queue {
+        static constexpr std::uint64_t busy = UINT64_MAX; // slot tag while being overwritten
+        static constexpr std::uint64_t none = UINT64_MAX; // nothing pinned
+
+        struct slot {
+            std::atomic<std::uint64_t> tag{0}; // sequence number + 1 of the stored message, 0 = empty
+            std::optional<C> value;
+        };
+
+        struct alignas(64) subscriber_state {
+            std::atomic<bool> claimed{false};
+            std::atomic<bool> active{false};
+            std::atomic<std::uint64_t> cursor{0}; // next sequence number to read
+            std::atomic<std::uint64_t> pinned{none}; // the sequence number being viewed (drop policy)
+            std::uint64_t dropped = 0;
+            bool viewing = false;
+        };
+
+    public:
+        using value_type = C;
+
+        class subscriber;
+
+        // A read-only view of a message in the ring. The message can't be
+        // overwritten while the view exists. With the block policy that holds
+        // back the producer, so keep it short-lived. A subscriber may only
+        // have one view at a time.
+        class view {
+        public:
+            view() = default;
+            view(const view&) = delete;            // no copies
+            view& operator=(const view&) = delete; // no copies
+            view(view&& other) noexcept { swap(other); }
+            view& operator=(view&& other) noexcept {
+                view(std::move(other)).swap(*this);
+                return *this;
+            }
+            ~view() { release(); }
+
+            inline const C& operator*() const { return *m_slot->value; }
+            inline const C* operator->() const { return &*m_slot->value; }
+            inline explicit operator bool() const { return m_slot != nullptr; }
+
+            inline std::uint64_t sequence() const { return m_seq; }
+            // the number of messages this subscriber missed just before this one
+            inline std::uint64_t gap() const { return m_gap; }
+
+            void release() {
+                if(m_slot) {
+                    m_state->viewing = false;
+                    m_state->cursor.store(m_seq + 1);
+                    m_state->pinned.store(none);
+                    m_queue->notify_producer();
+                    m_slot = nullptr;
+                }
+            }
+
+        private:
+            friend class subscriber;
+            view(broadcast_queue* queue, subscriber_state* state, const slot* sl, std::uint64_t seq,
+                 std::uint64_t gap) :
+                m_queue(queue),
+                m_state(state), m_slot(sl), m_seq(seq), m_gap(gap) {}
+
+            void swap(view& other) noexcept {
+                std::swap(m_queue, other.m_queue);
+                std::swap(m_state, other.m_state);
+                std::swap(m_slot, other.m_slot);
+                std::swap(m_seq, other.m_seq);
+                std::swap(m_gap, other.m_gap);
+            }
+
+            broadcast_queue* m_queue = nullptr;
+            subscriber_state* m_state = nullptr;
+            const slot* m_slot = nullptr;
+            std::uint64_t m_seq = 0;
+            std::uint64_t m_gap = 0;
+        };
+
+        // A registration in the queue. A subscriber sees all messages pushed
+        // after it was created and should only be used by one thread at a time.
+        class subscriber {
+        public:
+            subscriber(subscriber&& other) noexcept :
+                m_queue(std::exchange(other.m_queue, nullptr)), m_state(std::exchange(other.m_state, nullptr)) {}
+            subscriber& operator=(subscriber&&) = delete;
+            ~subscriber() {
+                if(m_state) {
+                    m_state->active.store(false);
+                    m_state->claimed.store(false);
+                    m_queue->notify_producer();
+                }
+            }
+
+            view next() { // blocking
+                if(m_state->viewing) throw std::logic_error("broadcast_queue::subscriber::next with an active view");
+                view res;
+                while(true) {
+                    if(!m_queue->m_alive) throw message_queue_exception(std::string("broadcast_queue::next shutdown"));
+                    if(acquire(res)) return res;
+                    m_queue->wait_for_data(m_state->cursor.load());
+                }
+            }
+            bool try_next(view& fill) { // polling
+                if(!m_queue->m_alive) throw message_queue_exception(std::string("broadcast_queue::next shutdown"));
+                if(m_state->viewing) throw std::logic_error("broadcast_queue::subscriber::next with an active view");
+                return acquire(fill);
+            }
+
+            // the total number of messages this subscriber has missed
+            inline std::uint64_t dropped() const { return m_state->dropped; }
+
+        private:
+            friend class broadcast_queue;
+            subscriber(broadcast_queue* queue, subscriber_state* state) : m_queue(queue), m_state(state) {}
+
+            bool acquire(view& fill) {
+                std::uint64_t gap = 0;
+                while(true) {
+                    auto seq = m_state->cursor.load();
+
+                    // pin before finding the slot, push() checks the pins
+                    // after marking the slot as busy
+                    if(m_queue->m_policy == slow_subscriber_policy::drop) m_state->pinned.store(seq);
+                    const slot& sl = m_queue->m_slots[m_queue->m_ring[seq & m_queue->m_mask].load()];
+                    auto tag = sl.tag.load();
+                    if(tag == seq + 1) {
+                        m_state->viewing = true;
+                        m_state->dropped += gap;
+                        fill = view(m_queue, m_state, &sl, seq, gap);
+                        return true;
+                    }
+                    m_state->pinned.store(none);
+                    if(tag == busy ? seq >= m_queue->m_published.load() : tag <= seq) return false; // not written yet
+
+                    // overwritten, skip to the oldest message that is not being overwritten
+                    auto oldest = m_queue->m_published.load() - m_queue->capacity() + 1;
+                    gap += oldest - seq;
+                    m_state->cursor.store(oldest);
+                }
+            }
+
+            broadcast_queue* m_queue;
+            subscriber_state* m_state;
+        };
+
+        // With the drop policy, max_subscribers extra slots are allocated to
+        // move messages that are being viewed out of the ring.
+        explicit broadcast_queue(std::size_t capacity, slow_subscriber_policy policy = slow_subscriber_policy::block,
+                                 std::size_t max_subscribers = 64) :
+            m_ring(round_up(capacity)),
+            m_mask(m_ring.size() - 1),
+            m_slots(m_ring.size() + (policy == slow_subscriber_policy::drop ? max_subscribers : 0)),
+            m_subs(max_subscribers), m_policy(policy) {
+            for(std::size_t i = 0; i < m_ring.size(); ++i) m_ring[i].store(static_cast<std::uint32_t>(i));
+            for(std::size_t i = m_ring.size(); i < m_slots.size(); ++i) m_spares.push_back(static_cast<std::uint32_t>(i));
+        }
+        broadcast_queue(const broadcast_queue&) = delete;            // no copies
+        broadcast_queue& operator=(const broadcast_queue&) = delete; // no copies
+        virtual ~broadcast_queue() { shutdown(); }
+
+        inline std::size_t capacity() const { return m_ring.size(); }
+
+        void shutdown() {
+            if(m_alive) {
+                m_alive = false;
+                std::lock_guard<std::mutex> lock(m_mtx);
+                m_data_cv.notify_all();
+                m_space_cv.notify_all();
+            }
+        }
+
+        subscriber subscribe() {
+            for(auto& state : m_subs) {
+                bool expected = false;
+                if(state.claimed.compare_exchange_strong(expected, true)) {
+                    state.pinned.store(none);
+                    state.dropped = 0;
+                    state.viewing = false;
+                    // Become active with a cursor the producer can't have
+                    // passed yet, then start at what has been published since.
+                    // A min_cursor() that didn't see this subscriber was
+                    // computed before the second load and can't exceed it.
+                    state.cursor.store(m_published.load());
+                    state.active.store(true);
+                    state.cursor.store(m_published.load());
+                    notify_producer();
+                    return {this, &state};
+                }
+            }
+            throw std::length_error("broadcast_queue::subscribe too many subscribers");
+        }
+
+        // push and emplace may only be called by one thread at a time
+        void push(const C& msg) { emplace(msg); }
+        void push(C&& msg) { emplace(std::move(msg)); }
+
+        template<class... Args>
+        void emplace(Args&&... args) {
+            if(!m_alive) throw message_queue_exception(std::string("broadcast_queue::push shutdown"));
+
+            auto seq = m_published.load(std::memory_order_relaxed);
+            auto& pos = m_ring[seq & m_mask];
+            slot* sl = &m_slots[pos.load(std::memory_order_relaxed)];
+            if(seq >= capacity()) { // overwriting seq - capacity
+                auto old = seq - capacity();
+                if(m_policy == slow_subscriber_policy::block) wait_for_space(old);
+                sl->tag.store(busy);
+                if(m_policy == slow_subscriber_policy::drop && pinned(old)) sl = swap_out(pos, *sl, old);
+            }
+            sl->value.emplace(std::forward<Args>(args)...);
+            sl->tag.store(seq + 1);
+            m_published.store(seq + 1);
+
+            if(m_waiting_subscribers.load()) {
+                std::lock_guard<std::mutex> lock(m_mtx);
+                m_data_cv.notify_all();
+            }
+        }
+
+    private:
+        static std::size_t round_up(std::size_t capacity) {
+            std::size_t res = 1;
+            while(res < capacity) res <<= 1;
+            return res;
+        }
+
+        // the lowest cursor of all active subscribers, or the next sequence number if there are none
+        std::uint64_t min_cursor() const {
+            auto res = m_published.load(std::memory_order_relaxed);
+            for(auto& state : m_subs) {
+                if(state.active.load()) {
+                    auto cursor = state.cursor.load();
+                    if(cursor < res) res = cursor;
+                }
+            }
+            return res;
+        }
+
+        // drop policy: true if a subscriber may be viewing the message seq
+        bool pinned(std::uint64_t seq) const {
+            for(auto& state : m_subs) {
+                if(state.active.load() && state.pinned.load() == seq) return true;
+            }
+            return false;
+        }
+
+        // Drop policy: viewed, the slot at pos holding the message old, is
+        // left alone and a spare slot takes its place in the ring.
+        // Subscribers pin before looking up the slot, so a spare that is not
+        // pinned can't be viewed: a later pin would find a slot that isn't in
+        // the ring anymore. There is always such a spare since a subscriber
+        // pins at most one message and viewed is pinned.
+        slot* swap_out(std::atomic<std::uint32_t>& pos, slot& viewed, std::uint64_t old) {
+            for(auto& spare : m_spares) {
+                slot& sl = m_slots[spare];
+                auto tag = sl.tag.load(std::memory_order_relaxed);
+                if(tag != 0 && pinned(tag - 1)) continue;
+                sl.tag.store(busy);
+                pos.store(std::exchange(spare, pos.load(std::memory_order_relaxed)));
+                viewed.tag.store(old + 1); // the message is still there
+                return &sl;
+            }
+            throw std::logic_error("broadcast_queue: no free spare slot"); // can't happen
+        }
+
+        // block policy: wait until all subscribers are done with old
+        void wait_for_space(std::uint64_t old) {
+            if(m_min_cursor > old) return;
+            m_min_cursor = min_cursor();
+            if(m_min_cursor > old) return;
+
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_producer_waiting.store(true);
+            while(m_alive && (m_min_cursor = min_cursor()) <= old) m_space_cv.wait(lock);
+            m_producer_waiting.store(false);
+            if(!m_alive) throw message_queue_exception(std::string("broadcast_queue::push shutdown"));
+        }
+
+        void notify_producer() {
+            if(m_producer_waiting.load()) {
+                std::lock_guard<std::mutex> lock(m_mtx);
+                m_space_cv.notify_one();
+            }
+        }
+
+        void wait_for_data(std::uint64_t cursor) {
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_waiting_subscribers.fetch_add(1);
+            while(m_alive && m_published.load() <= cursor) m_data_cv.wait(lock);
+            m_waiting_subscribers.fetch_sub(1);
+        }
+
+        std::vector<std::atomic<std::uint32_t>> m_ring; // the index in m_slots of every position
+        std::size_t m_mask;
+        std::vector<slot> m_slots;
+        std::vector<std::uint32_t> m_spares; // drop policy, slots not in the ring, used by the producer
+        std::vector<subscriber_state> m_subs;
+        slow_subscriber_policy m_policy;
+        std::atomic<std::uint64_t> m_published{0}; // the number of messages pushed
+        std::uint64_t m_min_cursor = 0;            // cached by the producer
+        std::atomic<bool> m_alive{true};
+
+        std::mutex m_mtx;
+        std::condition_variable m_data_cv;
+        std::condition_variable m_space_cv;
+        std::atomic<unsigned> m_waiting_subscribers{0};
+        std::atomic<bool> m_producer_waiting{false};
+    };
+} // namespace mq
+} // namespace lyn
@@ -0,0 +1,240 @@
+#pragma once
+
+/*
+ * Clock adapters usable as the Clock parameter of lyn::log_watch.
+ *
+ * All clocks count nanoseconds since the Unix epoch, like
+ * std::chrono::system_clock, and provide to_time_t / from_time_t.
+ */
+
+#include "lyn/abstract_thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#    include <cpuid.h>
+#    include <x86intrin.h>
+#    define LYN_HAS_TSC_CLOCK 1
+#elif defined(__aarch64__)
+#    define LYN_HAS_TSC_CLOCK 1
+#endif
+
+#if defined(CLOCK_REALTIME_COARSE)
+#    define LYN_HAS_COARSE_SYSTEM_CLOCK 1
+#endif
+
+namespace lyn {
+namespace chrono {
+    namespace detail {
+        // the parts common to all clocks with the same epoch as std::chrono::system_clock
+        template<class Derived>
+        struct unix_epoch_clock {
+            using rep = std::int64_t;
+            using period = std::nano;
+            using duration = std::chrono::duration<rep, period>;
+            using time_point = std::chrono::time_point<Derived, duration>;
+            static constexpr bool is_steady = false;
+
+            static std::time_t to_time_t(const time_point& tp) noexcept {
+                return static_cast<std::time_t>(
+                    std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count());
+            }
+            static time_point from_time_t(std::time_t t) noexcept {
+                return time_point(std::chrono::seconds(t));
+            }
+            static std::chrono::system_clock::time_point to_sys(const time_point& tp) noexcept {
+                return std::chrono::system_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(tp.time_since_epoch()));
+            }
+
+        protected:
+            template<class Clock>
+            static rep since_epoch(const typename Clock::time_point& tp) noexcept {
+                return std::chrono::duration_cast<duration>(tp.time_since_epoch()).count();
+            }
+        };
+    } // namespace detail
+
+#ifdef LYN_HAS_COARSE_SYSTEM_CLOCK
+    // -------------------------------------------------------------------------
+    // Reads CLOCK_REALTIME_COARSE. This is the time of the last kernel tick so
+    // the resolution is typically 1-4 ms, see resolution().
+    class coarse_system_clock : public detail::unix_epoch_clock<coarse_system_clock> {
+    public:
+        static time_point now() noexcept {
+            timespec ts;
+            clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+            return time_point(duration(static_cast<rep>(ts.tv_sec) * 1000000000 + ts.tv_nsec));
+        }
+        static duration resolution() noexcept {
+            timespec ts;
+            clock_getres(CLOCK_REALTIME_COARSE, &ts);
+            return duration(static_cast<rep>(ts.tv_sec) * 1000000000 + ts.tv_nsec);
+        }
+    };
+#endif
+
+#ifdef LYN_HAS_TSC_CLOCK
+    // -------------------------------------------------------------------------
+    // Reads the CPU time stamp counter and converts it to wall clock time
+    // using a calibration against std::chrono::system_clock that is made
+    // once, on the first call to now() or calibrate(). The calibration is
+    // never changed so, if the counter is invariant (see
+    // calibration::invariant), the clock is monotonic and ordered across
+    // threads. It will drift from system_clock by the frequency error of the
+    // calibration (typically a few ppm) and it will not follow NTP
+    // adjustments.
+    class tsc_clock : public detail::unix_epoch_clock<tsc_clock> {
+    public:
+        static time_point now() noexcept {
+            const auto& cal = calibrate();
+            // signed, a core whose counter is slightly behind may read less than base_ticks
+            auto elapsed = static_cast<std::int64_t>(ticks() - cal.base_ticks);
+            return time_point(duration(cal.base_ns + static_cast<rep>(static_cast<double>(elapsed) * cal.ns_per_tick)));
+        }
+
+        struct calibration {
+            std::uint64_t base_ticks;
+            rep base_ns;
+            double ns_per_tick;
+            bool invariant; // is_invariant() when calibrated, if false other cores may disagree
+        };
+
+        // Calibrates the clock by sampling the counter and system_clock over
+        // calibration_time. Only the first call has any effect. Call it early
+        // to not have the first now() take calibration_time.
+        static const calibration& calibrate(std::chrono::nanoseconds calibration_time = std::chrono::milliseconds(10)) {
+            static const calibration cal = [&] {
+                auto sys0 = std::chrono::system_clock::now();
+                auto tsc0 = ticks();
+                auto steady_end = std::chrono::steady_clock::now() + calibration_time;
+                while(std::chrono::steady_clock::now() < steady_end) {}
+                auto sys1 = std::chrono::system_clock::now();
+                auto tsc1 = ticks();
+                auto ns = std::chrono::duration_cast<duration>(sys1 - sys0).count();
+                return calibration{tsc1, since_epoch<std::chrono::system_clock>(sys1),
+                                   static_cast<double>(ns) / static_cast<double>(tsc1 - tsc0), is_invariant()};
+            }();
+            return cal;
+        }
+
+        // true if the counter ticks at a constant rate in all power states
+        // and is synchronized between cores
+        static bool is_invariant() noexcept {
+#    if defined(__x86_64__) || defined(__i386__)
+            unsigned eax, ebx, ecx, edx;
+            if(not __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+            return edx & (1U << 8);
+#    else
+            return true; // the generic timer on aarch64
+#    endif
+        }
+
+        // The counter is read after all preceding instructions have completed
+        // and before any following instruction starts, so reads are ordered
+        // with the surrounding memory operations.
+        static std::uint64_t ticks() noexcept {
+#    if defined(__x86_64__) || defined(__i386__)
+            _mm_lfence();
+            auto val = __rdtsc();
+            _mm_lfence();
+            return val;
+#    else
+            std::uint64_t val;
+            asm volatile("isb\n\tmrs %0, cntvct_el0\n\tisb" : "=r"(val) : : "memory");
+            return val;
+#    endif
+        }
+    };
+#endif
+
+    // -------------------------------------------------------------------------
+    // A clock whose now() only loads an atomic that is updated by a
+    // background thread at a configurable resolution. The time is never
+    // allowed to go backwards. While no updater is running, now() falls
+    // back to calling Clock::now(). Clock must use the Unix epoch.
+    //
+    //   lyn::chrono::cached_clock<>::updater upd(std::chrono::milliseconds(1));
+    //   upd.start();
+    //   lyn::log_watch<std::chrono::milliseconds, lyn::chrono::cached_clock<>> lw;
+    template<class Clock = std::chrono::system_clock>
+    class cached_clock : public detail::unix_epoch_clock<cached_clock<Clock>> {
+        using base = detail::unix_epoch_clock<cached_clock<Clock>>;
+
+    public:
+        using typename base::duration;
+        using typename base::rep;
+        using typename base::time_point;
+
+        static time_point now() noexcept {
+            auto ns = s_now.load(std::memory_order_acquire);
+            if(ns == 0) return time_point(duration(base::template since_epoch<Clock>(Clock::now())));
+            return time_point(duration(ns));
+        }
+
+        // Only one updater per Clock may run at a time, start() throws
+        // std::runtime_error if another one has been started and not yet
+        // destroyed.
+        class updater : public lyn::thread::abstract_thread {
+        public:
+            explicit updater(std::chrono::nanoseconds resolution = std::chrono::milliseconds(1)) :
+                m_resolution(resolution) {}
+            ~updater() override {
+                terminate_and_join();
+                if(m_owner) {
+                    s_now.store(0, std::memory_order_release);
+                    s_updating.store(false, std::memory_order_release);
+                }
+            }
+
+            void start() override {
+                bool claimed = false;
+                if(not m_owner) {
+                    if(s_updating.exchange(true, std::memory_order_acq_rel))
+                        throw std::runtime_error("cached_clock::updater: another updater is running");
+                    m_owner = claimed = true;
+                }
+                try {
+                    abstract_thread::start();
+                } catch(...) {
+                    if(claimed) {
+                        m_owner = false;
+                        s_updating.store(false, std::memory_order_release);
+                    }
+                    throw;
+                }
+            }
+
+        protected:
+            // now() is up to date when start() returns
+            void setup_in_thread() override { tick(); }
+
+            void execute() override {
+                while(not terminated()) {
+                    std::this_thread::sleep_for(m_resolution);
+                    tick();
+                }
+            }
+
+        private:
+            static void tick() noexcept {
+                auto ns = base::template since_epoch<Clock>(Clock::now());
+                if(ns > s_now.load(std::memory_order_relaxed)) s_now.store(ns, std::memory_order_release);
+            }
+
+            std::chrono::nanoseconds m_resolution;
+            bool m_owner = false; // of s_updating
+        };
+
+    private:
+        inline static std::atomic<rep> s_now{0};
+        inline static std::atomic<bool> s_updating{false}; // an updater owns s_now
+    };
+
+} // namespace chrono
+} // namespace lyn
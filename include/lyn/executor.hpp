@@ -0,0 +1,59 @@
+#pragma once
+
+/*
+ * Executors used to resume coroutines suspended in the awaitables of
+ * lyn::thread::event and lyn::mq::message_queue.
+ *
+ * Requires C++20
+ */
+
+#include <coroutine>
+#include <exception>
+
+#define LYN_HAS_COROUTINES 1
+
+namespace lyn {
+namespace thread {
+    // -------------------------------------------------------------------------
+    // The interface used by push() / set() to resume a suspended coroutine
+    class executor {
+    public:
+        virtual ~executor() = default;
+
+        // schedule handle to be resumed
+        virtual void post(std::coroutine_handle<> handle) = 0;
+    };
+
+    // Resumes the coroutine directly in the thread calling post(), which is
+    // the thread calling push() or set(), after any locks have been released.
+    class inline_executor final : public executor {
+    public:
+        void post(std::coroutine_handle<> handle) override { handle.resume(); }
+    };
+
+    inline executor& default_executor() {
+        static inline_executor ex;
+        return ex;
+    }
+    // -------------------------------------------------------------------------
+    // A coroutine return type for coroutines that nobody waits for
+    struct detached_task {
+        struct promise_type {
+            detached_task get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+    };
+
+    // co_await resume_on(ex) continues the coroutine via the executor ex
+    struct resume_on {
+        executor& ex;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { ex.post(handle); }
+        void await_resume() const noexcept {}
+    };
+} // namespace thread
+} // namespace lyn
@@ -12,6 +12,14 @@
  * "This is free and unencumbered software released into the public domain."
  */
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 //----------------------------------------------------------------------------------
@@ -78,4 +86,330 @@ C initialize(Args&&... args) {
     (..., emplace_somehow(res, std::forward<Args>(args)));
     return res;
 }
+//----------------------------------------------------------------------------------
+// Compile time constructed lookup tables
+//
+// lyn::static_initialize<C>(args...) is the constexpr counterpart of
+// lyn::initialize<C>(args...) for associative containers. Instead of a C it
+// returns an immutable std::array backed table that is sorted (or perfectly
+// hashed) at compile time when used to initialize a constexpr variable:
+//
+//   constexpr auto codes = lyn::static_initialize<std::map<int, std::string_view>>(
+//       std::pair{404, "Not Found"}, std::pair{200, "OK"});
+//
+//   C has mapped_type | C has hasher and a key convertible to std::string_view
+//   ------------------+--------------------------------------------------------
+//   no                | no  : static_flat_set<key_type, N, key_compare>
+//   yes               | no  : static_flat_map<key_type, mapped_type, N, key_compare>
+//   no                | yes : static_perfect_hash_set<N>
+//   yes               | yes : static_perfect_hash_map<mapped_type, N>
+//
+// Keys must be unique. Duplicates make the constant evaluation fail.
+//----------------------------------------------------------------------------------
+template<class, class = void>
+struct has_mapped_type : std::false_type {};
+
+template<class T>
+struct has_mapped_type<T, std::void_t<typename T::mapped_type>> : std::true_type {};
+
+template<class T>
+inline constexpr bool has_mapped_type_v = has_mapped_type<T>::value;
+//----------------------------------------------------------------------------------
+template<class, class = void>
+struct has_key_compare : std::false_type {};
+
+template<class T>
+struct has_key_compare<T, std::void_t<typename T::key_compare>> : std::true_type {};
+
+template<class T>
+inline constexpr bool has_key_compare_v = has_key_compare<T>::value;
+//----------------------------------------------------------------------------------
+template<class, class = void>
+struct has_hasher : std::false_type {};
+
+template<class T>
+struct has_hasher<T, std::void_t<typename T::hasher>> : std::true_type {};
+
+template<class T>
+inline constexpr bool has_hasher_v = has_hasher<T>::value;
+//----------------------------------------------------------------------------------
+namespace detail {
+    struct key_of_value {
+        template<class T>
+        constexpr const T& operator()(const T& v) const noexcept {
+            return v;
+        }
+    };
+    struct key_of_pair {
+        template<class T>
+        constexpr const auto& operator()(const T& v) const noexcept {
+            return v.first;
+        }
+    };
+
+    // C::key_compare if available, else std::less<C::key_type>
+    template<class C, bool = has_key_compare_v<C>>
+    struct key_compare_of {
+        using type = typename C::key_compare;
+    };
+    template<class C>
+    struct key_compare_of<C, false> {
+        using type = std::less<typename C::key_type>;
+    };
+
+    // Branch-light lower_bound: the loop body compiles to a conditional move
+    // and the number of iterations only depends on N.
+    template<class T, std::size_t N, class Key, class KeyOf, class Compare>
+    constexpr const T* flat_lower_bound(const std::array<T, N>& data, const Key& key, KeyOf key_of,
+                                        const Compare& comp) {
+        if constexpr(N == 0) {
+            return data.data();
+        } else {
+            const T* base = data.data();
+            std::size_t len = N;
+            while(len > 1) {
+                std::size_t half = len / 2;
+                base = comp(key_of(base[half - 1]), key) ? base + half : base;
+                len -= half;
+            }
+            return base + comp(key_of(*base), key);
+        }
+    }
+
+    template<class T, std::size_t N, class KeyOf, class Compare>
+    constexpr void sort_unique_keys(std::array<T, N>& data, KeyOf key_of, const Compare& comp) {
+        std::sort(data.begin(), data.end(),
+                  [&](const T& lhs, const T& rhs) { return comp(key_of(lhs), key_of(rhs)); });
+        for(std::size_t i = 1; i < N; ++i) {
+            if(not comp(key_of(data[i - 1]), key_of(data[i])))
+                throw std::invalid_argument("lyn::static_initialize: duplicate key");
+        }
+    }
+
+    // a sorted std::array with binary search lookups
+    template<class T, std::size_t N, class Compare, class KeyOf>
+    class flat_table {
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using key_compare = Compare;
+        using const_iterator = const value_type*;
+        using iterator = const_iterator;
+
+        constexpr explicit flat_table(std::array<T, N> data, const Compare& comp = Compare{}) :
+            m_data(std::move(data)), m_comp(comp) {
+            sort_unique_keys(m_data, KeyOf{}, m_comp);
+        }
+
+        constexpr const_iterator begin() const noexcept { return m_data.data(); }
+        constexpr const_iterator end() const noexcept { return m_data.data() + N; }
+        constexpr size_type size() const noexcept { return N; }
+        constexpr bool empty() const noexcept { return N == 0; }
+
+        template<class K>
+        constexpr const_iterator lower_bound(const K& key) const {
+            return flat_lower_bound(m_data, key, KeyOf{}, m_comp);
+        }
+        template<class K>
+        constexpr const_iterator find(const K& key) const {
+            auto it = lower_bound(key);
+            return it != end() && not m_comp(key, KeyOf{}(*it)) ? it : end();
+        }
+        template<class K>
+        constexpr bool contains(const K& key) const {
+            return find(key) != end();
+        }
+        template<class K>
+        constexpr size_type count(const K& key) const {
+            return contains(key);
+        }
+
+    private:
+        std::array<T, N> m_data;
+        [[no_unique_address]] Compare m_comp;
+    };
+
+    // FNV-1a with the seed folded into the offset basis
+    constexpr std::uint64_t seeded_hash(std::string_view str, std::uint64_t seed) noexcept {
+        std::uint64_t h = 0xcbf29ce484222325ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+        for(char ch : str) {
+            h ^= static_cast<unsigned char>(ch);
+            h *= 0x100000001b3ULL;
+        }
+        return h ^ (h >> 29);
+    }
+
+    // A "hash and displace" minimal perfect hash over std::string_view keys.
+    // Keys are first distributed into buckets using seed 0. Each bucket is then
+    // given its own seed that places all its keys in free slots. A lookup is
+    // two hashes, two table loads and one key comparison.
+    template<class T, std::size_t N, class KeyOf>
+    class perfect_hash_table {
+        static constexpr std::size_t slots = N == 0 ? 1 : std::bit_ceil(N);
+        static constexpr std::size_t mask = slots - 1;
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using const_iterator = const value_type*;
+        using iterator = const_iterator;
+
+        constexpr explicit perfect_hash_table(std::array<T, N> data) : m_data(std::move(data)) {
+            if constexpr(N != 0) build();
+        }
+
+        constexpr const_iterator begin() const noexcept { return m_data.data(); }
+        constexpr const_iterator end() const noexcept { return m_data.data() + N; }
+        constexpr size_type size() const noexcept { return N; }
+        constexpr bool empty() const noexcept { return N == 0; }
+
+        constexpr const_iterator find(std::string_view key) const noexcept {
+            if constexpr(N == 0) {
+                return end();
+            } else {
+                auto seed = m_seeds[seeded_hash(key, 0) & mask];
+                // unused slots refer to element 0 which can never be equal to
+                // a key that ends up in such a slot
+                const_iterator it = &m_data[m_slots[seeded_hash(key, seed) & mask]];
+                return KeyOf{}(*it) == key ? it : end();
+            }
+        }
+        constexpr bool contains(std::string_view key) const noexcept { return find(key) != end(); }
+        constexpr size_type count(std::string_view key) const noexcept { return contains(key); }
+
+    private:
+        constexpr void build() {
+            {
+                std::array<std::string_view, N> keys{};
+                for(std::size_t i = 0; i < N; ++i) keys[i] = KeyOf{}(m_data[i]);
+                std::sort(keys.begin(), keys.end());
+                for(std::size_t i = 1; i < N; ++i) {
+                    if(keys[i - 1] == keys[i]) throw std::invalid_argument("lyn::static_initialize: duplicate key");
+                }
+            }
+
+            std::array<std::size_t, N> bucket_of{};
+            std::array<std::size_t, slots> bucket_size{};
+            for(std::size_t i = 0; i < N; ++i) {
+                bucket_of[i] = seeded_hash(KeyOf{}(m_data[i]), 0) & mask;
+                ++bucket_size[bucket_of[i]];
+            }
+
+            // group the keys per bucket and place the largest buckets first
+            // while there are many free slots
+            std::array<std::size_t, N> order{};
+            for(std::size_t i = 0; i < N; ++i) order[i] = i;
+            std::sort(order.begin(), order.end(), [&](std::size_t lhs, std::size_t rhs) {
+                auto bl = bucket_of[lhs], br = bucket_of[rhs];
+                return bucket_size[bl] != bucket_size[br] ? bucket_size[bl] > bucket_size[br] : bl < br;
+            });
+
+            std::array<bool, slots> taken{};
+            std::array<std::size_t, N> placed{};
+            for(std::size_t first = 0; first < N;) {
+                auto bucket = bucket_of[order[first]];
+                auto last = first + bucket_size[bucket];
+
+                std::uint32_t seed = 1;
+                for(;; ++seed) {
+                    if(seed == 0x100000) throw std::logic_error("lyn::static_initialize: no perfect hash found");
+                    auto i = first;
+                    for(; i < last; ++i) {
+                        auto slot = seeded_hash(KeyOf{}(m_data[order[i]]), seed) & mask;
+                        if(taken[slot] || std::find(placed.begin() + first, placed.begin() + i, slot) !=
+                                              placed.begin() + i)
+                            break;
+                        placed[i] = slot;
+                    }
+                    if(i == last) break;
+                }
+
+                m_seeds[bucket] = seed;
+                for(auto i = first; i < last; ++i) {
+                    taken[placed[i]] = true;
+                    m_slots[placed[i]] = static_cast<std::uint32_t>(order[i]);
+                }
+                first = last;
+            }
+        }
+
+        std::array<T, N> m_data;
+        std::array<std::uint32_t, slots> m_seeds{};
+        std::array<std::uint32_t, slots> m_slots{};
+    };
+} // namespace detail
+//----------------------------------------------------------------------------------
+template<class Key, std::size_t N, class Compare = std::less<Key>>
+class static_flat_set : public detail::flat_table<Key, N, Compare, detail::key_of_value> {
+public:
+    using key_type = Key;
+    using detail::flat_table<Key, N, Compare, detail::key_of_value>::flat_table;
+};
+//----------------------------------------------------------------------------------
+template<class Key, class T, std::size_t N, class Compare = std::less<Key>>
+class static_flat_map : public detail::flat_table<std::pair<Key, T>, N, Compare, detail::key_of_pair> {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using detail::flat_table<std::pair<Key, T>, N, Compare, detail::key_of_pair>::flat_table;
+
+    template<class K>
+    constexpr const mapped_type& at(const K& key) const {
+        auto it = this->find(key);
+        if(it == this->end()) throw std::out_of_range("lyn::static_flat_map::at");
+        return it->second;
+    }
+};
+//----------------------------------------------------------------------------------
+template<std::size_t N>
+class static_perfect_hash_set : public detail::perfect_hash_table<std::string_view, N, detail::key_of_value> {
+public:
+    using key_type = std::string_view;
+    using detail::perfect_hash_table<std::string_view, N, detail::key_of_value>::perfect_hash_table;
+};
+//----------------------------------------------------------------------------------
+template<class T, std::size_t N>
+class static_perfect_hash_map :
+    public detail::perfect_hash_table<std::pair<std::string_view, T>, N, detail::key_of_pair> {
+public:
+    using key_type = std::string_view;
+    using mapped_type = T;
+    using detail::perfect_hash_table<std::pair<std::string_view, T>, N, detail::key_of_pair>::perfect_hash_table;
+
+    constexpr const mapped_type& at(std::string_view key) const {
+        auto it = this->find(key);
+        if(it == this->end()) throw std::out_of_range("lyn::static_perfect_hash_map::at");
+        return it->second;
+    }
+};
+//----------------------------------------------------------------------------------
+// builds a constexpr lookup table with the characteristics of the associative
+// container C, see the table above
+template<class C, class... Args>
+    requires(... && can_emplace_somehow<C, Args>)
+constexpr auto static_initialize(Args&&... args) {
+    using key_type = typename C::key_type;
+    constexpr std::size_t N = sizeof...(Args);
+
+    if constexpr(has_hasher_v<C> && std::is_convertible_v<key_type, std::string_view>) {
+        if constexpr(has_mapped_type_v<C>) {
+            using value_type = std::pair<std::string_view, typename C::mapped_type>;
+            return static_perfect_hash_map<typename C::mapped_type, N>(
+                std::array<value_type, N>{value_type(std::forward<Args>(args))...});
+        } else {
+            return static_perfect_hash_set<N>(
+                std::array<std::string_view, N>{std::string_view(std::forward<Args>(args))...});
+        }
+    } else {
+        using compare = typename detail::key_compare_of<C>::type;
+        if constexpr(has_mapped_type_v<C>) {
+            using value_type = std::pair<key_type, typename C::mapped_type>;
+            return static_flat_map<key_type, typename C::mapped_type, N, compare>(
+                std::array<value_type, N>{value_type(std::forward<Args>(args))...});
+        } else {
+            return static_flat_set<key_type, N, compare>(
+                std::array<key_type, N>{key_type(std::forward<Args>(args))...});
+        }
+    }
+}
 } // namespace lyn
@@ -12,9 +12,17 @@
 
 #include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <string>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#    include <span>
+#    define LYN_LOG_WATCH_SPAN 1
+#endif
 
 namespace lyn {
 
@@ -31,6 +39,52 @@ constexpr std::size_t log10ish() {
 
 using unanoseconds = std::chrono::duration<std::uint64_t, std::nano>;
 
+namespace detail {
+    // The std::tm part of the last time point formatted by a log_watch in
+    // the current thread. It is only re-rendered when the second or the
+    // format changes.
+    class log_watch_prefix {
+    public:
+        // returns nullptr if the result is too long to be cached
+        const log_watch_prefix* update(std::time_t t, const std::string& format) {
+            if(t == m_time && format.size() == m_format_len && std::memcmp(format.data(), m_format, m_format_len) == 0)
+                return this;
+            if(format.size() >= sizeof m_format) return nullptr;
+
+            std::tm tm{};
+#if defined(_WIN32)
+            localtime_s(&tm, &t);
+#else
+            localtime_r(&t, &tm);
+#endif
+            m_len = std::strftime(m_prefix, sizeof m_prefix, format.c_str(), &tm);
+            if(m_len == 0 && not format.empty()) {
+                m_format_len = sizeof m_format; // invalidate
+                return nullptr;
+            }
+            m_time = t;
+            m_format_len = format.size();
+            std::memcpy(m_format, format.data(), m_format_len);
+            return this;
+        }
+
+        const char* data() const { return m_prefix; }
+        std::size_t size() const { return m_len; }
+
+    private:
+        std::time_t m_time{};
+        std::size_t m_format_len = sizeof m_format; // nothing cached
+        std::size_t m_len = 0;
+        char m_format[64];
+        char m_prefix[128];
+    };
+
+    inline log_watch_prefix& log_watch_prefix_cache() {
+        thread_local log_watch_prefix cache;
+        return cache;
+    }
+} // namespace detail
+
 // A class to support using different precisions, chrono clocks and formats
 template<class Precision = std::chrono::seconds, class Clock = std::chrono::system_clock>
 class log_watch {
@@ -54,10 +108,60 @@ public:
     }
     inline log_watch& operator()(const Precision& p) { return (*this)(time_point(p)); }
 
+    // Formats the time point into the buffer [out, out + size) without
+    // allocating and without a terminating null character. Returns the
+    // number of characters written or 0 if they did not fit.
+    //
+    // The std::tm part is cached per thread and only re-rendered (using the
+    // reentrant localtime_r) when the second changes. The decimal_width sub
+    // second digits are rendered on every call.
+    std::size_t format_to(char* out, std::size_t size) const {
+        std::time_t t = Clock::to_time_t(whole_seconds());
+
+        std::size_t len;
+        if(auto prefix = detail::log_watch_prefix_cache().update(t, m_format)) {
+            len = prefix->size();
+            if(len + decimal_width > size) return 0;
+            std::memcpy(out, prefix->data(), len);
+        } else { // not cacheable, render directly into the buffer
+            std::tm tm{};
+#if defined(_WIN32)
+            localtime_s(&tm, &t);
+#else
+            localtime_r(&t, &tm);
+#endif
+            len = std::strftime(out, size, m_format.c_str(), &tm);
+            if(len == 0 || len + decimal_width > size) return 0;
+        }
+
+        if(decimal_width) { // if constexpr( ... in C++17
+            auto value = static_cast<std::uint64_t>(subseconds().count());
+            for(std::size_t i = len + decimal_width; i-- > len;) {
+                out[i] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            }
+        }
+        return len + decimal_width;
+    }
+
+#ifdef LYN_LOG_WATCH_SPAN
+    std::size_t format_to(std::span<char> out) const { return format_to(out.data(), out.size()); }
+#endif
+
     template<class P, class C>
     friend std::ostream& operator<<(std::ostream&, const log_watch<P, C>&);
 
 private:
+    // m_tp rounded down to whole seconds, also before the epoch
+    time_point whole_seconds() const {
+        auto dur = m_tp.time_since_epoch();
+        auto secs = std::chrono::duration_cast<std::chrono::seconds>(dur);
+        if(secs > dur) secs -= std::chrono::seconds{1};
+        return time_point(std::chrono::duration_cast<typename time_point::duration>(secs));
+    }
+    // the non-negative time since whole_seconds()
+    Precision subseconds() const { return std::chrono::duration_cast<Precision>(m_tp - whole_seconds()); }
+
     std::string m_format;
     time_point m_tp;
 };
@@ -66,19 +170,16 @@ template<class Precision, class Clock>
 std::ostream& operator<<(std::ostream& os, const log_watch<Precision, Clock>& lw) {
     std::ostringstream oss;
 
-    // extract std::time_t from time_point
-    std::time_t t = Clock::to_time_t(lw.m_tp);
+    // extract std::time_t from time_point, rounded down to whole seconds
+    std::time_t t = Clock::to_time_t(lw.whole_seconds());
 
     // output the part supported by std::tm
     oss << std::put_time(std::localtime(&t), lw.m_format.c_str());
 
     // only involve chrono duration calc for displaying sub second precisions
     if(lw.decimal_width) { // if constexpr( ... in C++17
-        // get duration since epoch
-        auto dur = lw.m_tp.time_since_epoch();
-
         // extract the sub second part from the duration since epoch
-        auto subsec = std::chrono::duration_cast<Precision>(dur) % std::chrono::seconds{1};
+        auto subsec = lw.subseconds();
 
         // output the sub second part
         oss << std::setfill('0') << std::setw(lw.decimal_width) << subsec.count();
@@ -10,6 +10,10 @@
 #include <thread>
 #include <utility>
 
+#ifdef LYN_HAS_COROUTINES
+#    include <optional>
+#endif
+
 namespace lyn {
 namespace mq {
     struct message_queue_exception : public std::runtime_error {
@@ -23,6 +27,17 @@ namespace mq {
         using queue_t = std::queue<C>;
 
         message_queue() : m_cv(), m_mtx(), m_queue(), m_alive(true) {}
+#ifdef LYN_HAS_EVENTFD
+        // notification_fd() is readable while there are messages in the queue
+        // and after shutdown(). Only a push onto an empty queue writes to it
+        // and a pop that leaves the queue empty reads from it, both with the
+        // lock held. When poll/epoll reports it as readable, drain the queue
+        // using the polling pop_all(queue_t&), which throws after shutdown().
+        explicit message_queue(lyn::thread::use_eventfd_t tag) : message_queue() { m_efd = eventfd_handle(tag); }
+
+        // the eventfd or -1 if the queue was not created with use_eventfd
+        inline int notification_fd() const { return m_efd.fd(); }
+#endif
         message_queue(const message_queue&) = delete;            // no copies
         message_queue& operator=(const message_queue&) = delete; // no copies
         virtual ~message_queue() { shutdown(); }
@@ -32,22 +47,36 @@ namespace mq {
             if(m_alive) {
                 m_alive = false;
                 m_cv.notify_all();
+#ifdef LYN_HAS_EVENTFD
+                // wake up pollers, their next pop throws
+                if(m_efd) {
+                    std::lock_guard<std::mutex> lock(m_mtx);
+                    if(!m_efd_armed) {
+                        m_efd_armed = true;
+                        m_efd.signal();
+                    }
+                }
+#endif
+                // resume all suspended coroutines, making async_pop / async_pop_all throw
+                lyn::thread::detail::waiter_resumer resumer;
+                {
+                    std::lock_guard<std::mutex> lock(m_mtx);
+                    std::swap(resumer.waiters, m_waiters);
+                }
             }
         }
         void push(const C& msg) {
             if(!m_alive) throw message_queue_exception(std::string("message_queue::push shutdown"));
-            lyn::thread::guard_then_notify_using<lyn::thread::notifier_of_one>(m_mtx, m_cv, [&] { m_queue.push(msg); });
+            push_using([&] { m_queue.push(msg); });
         }
         void push(C&& msg) {
             if(!m_alive) throw message_queue_exception(std::string("message_queue::push shutdown"));
-            lyn::thread::guard_then_notify_using<lyn::thread::notifier_of_one>(m_mtx, m_cv,
-                                                                               [&] { m_queue.push(std::move(msg)); });
+            push_using([&] { m_queue.push(std::move(msg)); });
         }
         template<class... Args>
         void emplace(Args&&... args) {
             if(!m_alive) throw message_queue_exception(std::string("message_queue::emplace shutdown"));
-            lyn::thread::guard_then_notify_using<lyn::thread::notifier_of_one>(
-                m_mtx, m_cv, [&] { m_queue.emplace(std::forward<Args>(args)...); });
+            push_using([&] { m_queue.emplace(std::forward<Args>(args)...); });
         }
         auto pop() { // blocking pop
             std::unique_lock<std::mutex> lock(m_mtx);
@@ -55,6 +84,7 @@ namespace mq {
             if(!m_alive) throw message_queue_exception(std::string("message_queue::pop shutdown"));
             auto msg = std::move(m_queue.front());
             m_queue.pop();
+            drained();
             return msg;
         }
         bool pop(C& fill) { // polling pop
@@ -63,6 +93,7 @@ namespace mq {
             if(m_queue.empty()) return false;
             fill = std::move(m_queue.front());
             m_queue.pop();
+            drained();
             return true;
         }
         queue_t pop_all() { // getting the whole queue, blocking
@@ -71,6 +102,7 @@ namespace mq {
             while(m_alive && m_queue.empty()) m_cv.wait(lock);
             if(!m_alive) throw message_queue_exception(std::string("message_queue::pop_all shutdown"));
             replacement.swap(m_queue);
+            drained();
             return replacement;
         }
         bool pop_all(queue_t& fill) { // getting the whole queue, polling
@@ -78,14 +110,142 @@ namespace mq {
             std::lock_guard<std::mutex> guard(m_mtx);
             if(m_queue.empty()) return false;
             fill.swap(m_queue);
+            drained();
             return true;
         }
 
     private:
+        // a coroutine suspended in async_pop or async_pop_all
+        struct async_waiter : lyn::thread::detail::waiter_hook {
+            virtual void deliver(queue_t& queue) = 0; // takes what it needs from a non-empty queue
+        };
+
+#ifdef LYN_HAS_COROUTINES
+        class async_awaitable : protected async_waiter {
+        public:
+            async_awaitable(message_queue& mq, lyn::thread::executor& ex) : m_mq(mq), m_ex(ex) {
+                this->resume = &post;
+            }
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle) {
+                m_handle = handle;
+                std::lock_guard<std::mutex> lock(m_mq.m_mtx);
+                if(!m_mq.m_alive) return false; // await_resume throws
+                if(!m_mq.m_queue.empty()) {
+                    this->deliver(m_mq.m_queue);
+                    m_mq.drained();
+                    return false;
+                }
+                m_mq.m_waiters.push_back(this);
+                return true;
+            }
+
+        private:
+            static void post(lyn::thread::detail::waiter_hook& hook) {
+                auto& self = static_cast<async_awaitable&>(hook);
+                self.m_ex.post(self.m_handle);
+            }
+
+            message_queue& m_mq;
+            lyn::thread::executor& m_ex;
+            std::coroutine_handle<> m_handle;
+        };
+
+    public:
+        class async_pop_awaitable : public async_awaitable {
+        public:
+            using async_awaitable::async_awaitable;
+
+            C await_resume() {
+                if(!m_msg) throw message_queue_exception(std::string("message_queue::async_pop shutdown"));
+                return std::move(*m_msg);
+            }
+
+        private:
+            void deliver(queue_t& queue) override {
+                m_msg.emplace(std::move(queue.front()));
+                queue.pop();
+            }
+            std::optional<C> m_msg;
+        };
+
+        class async_pop_all_awaitable : public async_awaitable {
+        public:
+            using async_awaitable::async_awaitable;
+
+            queue_t await_resume() {
+                if(!m_msgs) throw message_queue_exception(std::string("message_queue::async_pop_all shutdown"));
+                return std::move(*m_msgs);
+            }
+
+        private:
+            void deliver(queue_t& queue) override {
+                m_msgs.emplace();
+                m_msgs->swap(queue);
+            }
+            std::optional<queue_t> m_msgs;
+        };
+
+        // co_await-able pop. A suspended coroutine is resumed via ex by the
+        // push() that gives it the message.
+        async_pop_awaitable async_pop(lyn::thread::executor& ex = lyn::thread::default_executor()) {
+            return {*this, ex};
+        }
+        // co_await-able pop_all
+        async_pop_all_awaitable async_pop_all(lyn::thread::executor& ex = lyn::thread::default_executor()) {
+            return {*this, ex};
+        }
+#endif
+
+    private:
+        // what to do when the lock has been released after a push
+        struct push_result {
+            async_waiter* waiter = nullptr;
+        };
+
+        template<class Func>
+        void push_using(Func&& func) {
+            auto res = lyn::thread::guard_then_notify_using<lyn::thread::notifier_of_one>(m_mtx, m_cv, [&] {
+                push_result r;
+                func();
+                // hand the message over to the first suspended coroutine, if any
+                r.waiter = static_cast<async_waiter*>(m_waiters.pop_front());
+                if(r.waiter) r.waiter->deliver(m_queue);
+#ifdef LYN_HAS_EVENTFD
+                // Only write to the eventfd when the queue becomes non-empty.
+                // Writing it with the lock held orders the write before the
+                // read of a pop that drains the queue.
+                if(m_efd && !m_efd_armed && !m_queue.empty()) {
+                    m_efd_armed = true;
+                    m_efd.signal();
+                }
+#endif
+                return r;
+            });
+            if(res.waiter) res.waiter->resume(*res.waiter);
+        }
+
+        // called with the lock held after popping
+        inline void drained() {
+#ifdef LYN_HAS_EVENTFD
+            if(m_efd_armed && m_queue.empty()) {
+                m_efd_armed = false;
+                m_efd.clear();
+            }
+#endif
+        }
+
         std::condition_variable m_cv;
         mutable std::mutex m_mtx;
         queue_t m_queue;
         std::atomic<bool> m_alive;
+        lyn::thread::detail::waiter_list m_waiters; // see lyn::thread::detail::waiter_hook
+#ifdef LYN_HAS_EVENTFD
+        using eventfd_handle = lyn::thread::detail::eventfd_handle;
+        eventfd_handle m_efd;
+        bool m_efd_armed = false; // m_efd may be readable
+#endif
     };
 } // namespace mq
 } // namespace lyn
@@ -17,7 +17,6 @@ class multi_iterator {
 public:
     multi_iterator(Ts&... args) : its{{std::begin(args)...}, {std::end(args)...}} {}
 
-    template <class IT>
     struct iterator {
         using ref_type = std::tuple<decltype(*std::begin(std::declval<Ts&>()))...>;
 
@@ -0,0 +1,108 @@
+#pragma once
+
+/*
+ * lyn::detail::node_store
+ * Nodes addressed by 32 bit indices, allocated in chunks that are never
+ * moved or freed before the store, and a lock-free stack of free node
+ * indices. Used by lyn::object_pool and lyn::thread::timing_wheel.
+ *
+ * Requires C++14
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace lyn {
+namespace detail {
+    // Node must be default constructible. Next is the member linking a node
+    // to the next one in the free stack. BaseBits is log2 of the size of the
+    // first chunk.
+    template<class Node, std::atomic<std::uint32_t> Node::*Next, unsigned BaseBits>
+    class node_store {
+    public:
+        static constexpr std::uint32_t nil = UINT32_MAX;
+
+        node_store() = default;
+        node_store(const node_store&) = delete;            // no copies
+        node_store& operator=(const node_store&) = delete; // no copies
+
+        inline Node& operator[](std::uint32_t index) const noexcept {
+            unsigned k = chunk_of(index);
+            return m_chunks[k].load(std::memory_order_acquire)[index - chunk_begin(k)];
+        }
+
+        // the number of allocated nodes, indices below it are valid
+        inline std::uint32_t size() const noexcept { return m_size.load(std::memory_order_acquire); }
+
+        // -------------------------------------------------------------------------
+        // The free stack is popped by any thread so its head carries an ABA
+        // tag in the upper 32 bits.
+
+        // returns the index of the node on top of the free stack, or nil if it's empty
+        std::uint32_t pop() {
+            auto head = m_free.load(std::memory_order_acquire);
+            while(true) {
+                auto index = static_cast<std::uint32_t>(head);
+                if(index == nil) return nil;
+                auto next = ((*this)[index].*Next).load(std::memory_order_relaxed);
+                if(m_free.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | next, std::memory_order_acquire,
+                                                std::memory_order_acquire)) {
+                    return index;
+                }
+            }
+        }
+
+        // pushes the nodes first to last, already linked by Next, onto the free stack
+        void push(std::uint32_t first, std::uint32_t last) {
+            auto& link = (*this)[last].*Next;
+            auto head = m_free.load(std::memory_order_relaxed);
+            do {
+                link.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+            } while(not m_free.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | first, std::memory_order_release,
+                                                     std::memory_order_relaxed));
+        }
+
+        // -------------------------------------------------------------------------
+        // Allocates the next chunk unless the free stack has been refilled by
+        // another thread, then calls make_free(begin, count) which is to push
+        // the new nodes, [begin, begin + count), onto the free stack. Throws
+        // std::length_error(what) when all indices are in use.
+        template<class MakeFree>
+        void grow(const char* what, MakeFree&& make_free) {
+            std::lock_guard<std::mutex> lock(m_grow_mtx);
+            if(static_cast<std::uint32_t>(m_free.load(std::memory_order_acquire)) != nil) return; // someone else did
+            auto k = chunk_of(m_size.load(std::memory_order_relaxed));
+            if(k >= max_chunks - 1) throw std::length_error(what);
+            std::uint32_t count = 1U << (k + BaseBits);
+            auto begin = chunk_begin(k);
+
+            m_owned[k].reset(new Node[count]);
+            m_chunks[k].store(m_owned[k].get(), std::memory_order_release);
+            m_size.store(begin + count, std::memory_order_release);
+            std::forward<MakeFree>(make_free)(begin, count);
+        }
+
+    private:
+        // Nodes are allocated in chunks of geometrically growing size so that
+        // an index can be mapped to its node without locking:
+        // chunk k holds the indices [base * (2^k - 1), base * (2^(k+1) - 1))
+        static constexpr unsigned max_chunks = 32 - BaseBits;
+
+        static unsigned chunk_of(std::uint32_t index) noexcept {
+            return 31 - static_cast<unsigned>(__builtin_clz((index >> BaseBits) + 1));
+        }
+        static std::uint32_t chunk_begin(unsigned k) noexcept { return ((1U << k) - 1) << BaseBits; }
+
+        std::atomic<Node*> m_chunks[max_chunks]{};
+        std::unique_ptr<Node[]> m_owned[max_chunks];
+        std::atomic<std::uint32_t> m_size{0};
+        std::mutex m_grow_mtx;
+
+        std::atomic<std::uint64_t> m_free{nil}; // ABA tag << 32 | index
+    };
+} // namespace detail
+} // namespace lyn
@@ -0,0 +1,278 @@
+#pragma once
+
+/*
+ * lyn::object_pool and lyn::pool_handle
+ * Recycles objects, and the buffers they own, instead of destroying them.
+ * Every thread keeps a magazine of free objects per pool so that acquiring
+ * and releasing an object usually doesn't touch shared memory. Full and
+ * empty magazines are balanced using a lock-free stack of batches.
+ */
+
+#include "lyn/node_store.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lyn {
+
+template<class T>
+class object_pool;
+
+namespace detail {
+    template<class T>
+    struct pool_node {
+        ~pool_node() {
+            if(constructed) object().~T();
+        }
+        T& object() noexcept { return *reinterpret_cast<T*>(&storage); }
+
+        alignas(T) unsigned char storage[sizeof(T)];
+        bool constructed = false;
+        std::uint32_t index = 0;
+        std::uint32_t next = 0;                // the next node in the same batch
+        std::atomic<std::uint32_t> next_batch{0}; // the next batch in the pool's free stack of batches
+    };
+
+    // The pools that exist, by id. A thread that exits while it still has
+    // objects cached for a pool returns them only if the pool is still here.
+    struct pool_registry {
+        static pool_registry& instance() {
+            static pool_registry registry;
+            return registry;
+        }
+        std::uint64_t add(void* pool) {
+            std::lock_guard<std::mutex> lock(mtx);
+            pools.emplace(++last_id, pool);
+            return last_id;
+        }
+        void remove(std::uint64_t id) {
+            std::lock_guard<std::mutex> lock(mtx);
+            pools.erase(id);
+        }
+
+        std::mutex mtx;
+        std::unordered_map<std::uint64_t, void*> pools;
+        std::uint64_t last_id = 0;
+    };
+} // namespace detail
+
+// -----------------------------------------------------------------------------
+/**
+ * \brief Owns an object acquired from an object_pool and gives it back to
+ *        the pool when destroyed
+ *
+ * The handle is movable but not copyable, like a std::unique_ptr. It can
+ * be destroyed in any thread, as long as the pool is still alive.
+ */
+template<class T>
+class pool_handle {
+public:
+    pool_handle() = default;
+    pool_handle(const pool_handle&) = delete;            // no copies
+    pool_handle& operator=(const pool_handle&) = delete; // no copies
+    pool_handle(pool_handle&& other) noexcept :
+        m_pool(std::exchange(other.m_pool, nullptr)), m_node(std::exchange(other.m_node, nullptr)) {}
+    pool_handle& operator=(pool_handle&& other) noexcept {
+        pool_handle(std::move(other)).swap(*this);
+        return *this;
+    }
+    ~pool_handle() { reset(); }
+
+    inline T& operator*() const noexcept { return m_node->object(); }
+    inline T* operator->() const noexcept { return &m_node->object(); }
+    inline T* get() const noexcept { return m_node ? &m_node->object() : nullptr; }
+    inline explicit operator bool() const noexcept { return m_node != nullptr; }
+
+    // gives the object back to the pool
+    void reset() {
+        if(m_node) {
+            m_pool->release(*m_node);
+            m_node = nullptr;
+        }
+    }
+
+    void swap(pool_handle& other) noexcept {
+        std::swap(m_pool, other.m_pool);
+        std::swap(m_node, other.m_node);
+    }
+
+private:
+    friend class object_pool<T>;
+    pool_handle(object_pool<T>* pool, detail::pool_node<T>* node) noexcept : m_pool(pool), m_node(node) {}
+
+    object_pool<T>* m_pool = nullptr;
+    detail::pool_node<T>* m_node = nullptr;
+};
+
+// -----------------------------------------------------------------------------
+/**
+ * \brief A pool of default constructible objects that are reused rather
+ *        than destroyed
+ *
+ * Objects are default constructed the first time they are handed out and
+ * destroyed with the pool. A recycled object is in the state its previous
+ * user left it, so assign to it, which lets it reuse its buffers, rather
+ * than assuming it's empty.
+ *
+ * Each thread caches up to 2 * magazine_size free objects per pool.
+ * Objects released beyond that are returned to the pool in batches of
+ * magazine_size, and a thread that runs out takes a whole batch, so only
+ * one in magazine_size acquire or release calls touches shared memory.
+ *
+ * The pool must outlive all handles to its objects.
+ */
+template<class T>
+class object_pool {
+    using node = detail::pool_node<T>;
+    // the free stack holds batches of at most m_magazine_size nodes, linked by their first nodes
+    using store_type = detail::node_store<node, &node::next_batch, 6>;
+    static constexpr std::uint32_t nil = store_type::nil;
+
+public:
+    using value_type = T;
+    using handle = pool_handle<T>;
+
+    explicit object_pool(std::size_t magazine_size = 32) :
+        m_magazine_size(checked(magazine_size)), m_id(detail::pool_registry::instance().add(this)) {}
+    object_pool(const object_pool&) = delete;            // no copies
+    object_pool& operator=(const object_pool&) = delete; // no copies
+    ~object_pool() { detail::pool_registry::instance().remove(m_id); }
+
+    // get an object, creating one if there are no free objects
+    handle acquire() {
+        magazine& mag = local();
+        if(mag.count == 0) refill(mag);
+        node& n = *mag.nodes[--mag.count];
+        if(not n.constructed) {
+            try {
+                new(&n.storage) T();
+            } catch(...) {
+                mag.nodes[mag.count++] = &n;
+                throw;
+            }
+            n.constructed = true;
+            m_size.fetch_add(1, std::memory_order_relaxed);
+        }
+        return {this, &n};
+    }
+
+    // the number of objects created by the pool
+    inline std::size_t size() const noexcept { return m_size.load(std::memory_order_relaxed); }
+
+    // give the objects cached by the calling thread back to the pool
+    void release_thread_cache() {
+        magazine& mag = local();
+        flush(mag, mag.count);
+    }
+
+private:
+    friend class pool_handle<T>;
+
+    // the free objects a thread has cached for one pool
+    struct magazine {
+        object_pool* pool;
+        std::uint64_t id;
+        std::unique_ptr<node*[]> nodes;
+        std::uint32_t count;
+    };
+
+    struct thread_cache {
+        ~thread_cache() {
+            auto& registry = detail::pool_registry::instance();
+            std::lock_guard<std::mutex> lock(registry.mtx);
+            for(auto& mag : magazines) {
+                if(mag->count && registry.pools.count(mag->id)) mag->pool->flush(*mag, mag->count);
+            }
+        }
+        std::vector<std::unique_ptr<magazine>> magazines;
+        magazine* last = nullptr;
+    };
+
+    static std::uint32_t checked(std::size_t magazine_size) {
+        if(magazine_size == 0 || magazine_size >= nil / 2) throw std::invalid_argument("object_pool: magazine_size");
+        return static_cast<std::uint32_t>(magazine_size);
+    }
+
+    magazine& local() {
+        static thread_local thread_cache cache;
+        if(cache.last && cache.last->id == m_id) return *cache.last;
+        return find_magazine(cache);
+    }
+
+    magazine& find_magazine(thread_cache& cache) {
+        for(auto& mag : cache.magazines) {
+            if(mag->id == m_id) return *(cache.last = mag.get());
+        }
+        {
+            // forget the magazines of pools that are gone
+            auto& registry = detail::pool_registry::instance();
+            std::lock_guard<std::mutex> lock(registry.mtx);
+            auto& mags = cache.magazines;
+            for(std::size_t i = 0; i < mags.size();) {
+                if(registry.pools.count(mags[i]->id)) {
+                    ++i;
+                } else {
+                    mags[i] = std::move(mags.back());
+                    mags.pop_back();
+                }
+            }
+        }
+        cache.magazines.emplace_back(new magazine{this, m_id, std::make_unique<node*[]>(2 * m_magazine_size), 0});
+        return *(cache.last = cache.magazines.back().get());
+    }
+
+    void release(node& n) {
+        magazine& mag = local();
+        if(mag.count == 2 * m_magazine_size) flush(mag, m_magazine_size);
+        mag.nodes[mag.count++] = &n;
+    }
+
+    // returns the last count nodes in the magazine to the pool
+    void flush(magazine& mag, std::uint32_t count) {
+        while(count) {
+            auto batch = count < m_magazine_size ? count : m_magazine_size;
+            node** first = mag.nodes.get() + mag.count - batch;
+            for(std::uint32_t i = 0; i + 1 < batch; ++i) first[i]->next = first[i + 1]->index;
+            first[batch - 1]->next = nil;
+            m_store.push((*first)->index, (*first)->index);
+            mag.count -= batch;
+            count -= batch;
+        }
+    }
+
+    void refill(magazine& mag) {
+        auto index = m_store.pop();
+        while(index == nil) {
+            grow();
+            index = m_store.pop();
+        }
+        for(; index != nil; index = m_store[index].next) mag.nodes[mag.count++] = &m_store[index];
+    }
+
+    void grow() {
+        m_store.grow("object_pool: too many objects", [this](std::uint32_t begin, std::uint32_t count) {
+            for(std::uint32_t i = 0; i < count; ++i) {
+                node& n = m_store[begin + i];
+                n.index = begin + i;
+                n.next = (i + 1) % m_magazine_size && i + 1 < count ? begin + i + 1 : nil;
+            }
+            for(std::uint32_t i = 0; i < count; i += m_magazine_size) m_store.push(begin + i, begin + i);
+        });
+    }
+
+    // -------------------------------------------------------------------------
+    const std::uint32_t m_magazine_size;
+    const std::uint64_t m_id; // in the pool_registry
+
+    store_type m_store;
+    std::atomic<std::size_t> m_size{0};
+};
+} // namespace lyn
@@ -0,0 +1,212 @@
+#pragma once
+
+/*
+ * lyn::thread::seqlock and lyn::thread::triple_buffer
+ * Publishing snapshots of state from a writer to readers without the
+ * readers ever taking a lock or making the writer wait.
+ */
+
+#include "lyn/thread.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace lyn {
+namespace thread {
+    // -------------------------------------------------------------------------
+    /**
+     * \brief A sequence lock for small, trivially copyable, snapshots
+     *
+     * Readers copy the value out and retry if a store overlapped the copy.
+     * They never write to shared memory, so any number of readers can load
+     * concurrently without contending on a cache line. Stores never wait for
+     * readers, only for other stores.
+     */
+    template<class T>
+    class seqlock {
+        static_assert(std::is_trivially_copyable<T>::value, "seqlock<T> requires a trivially copyable T");
+
+    public:
+        using value_type = T;
+
+        seqlock() : seqlock(T{}) {}
+        explicit seqlock(const T& value) { write_words(value); }
+        seqlock(const seqlock&) = delete;            // no copies
+        seqlock& operator=(const seqlock&) = delete; // no copies
+
+        /**
+         * \brief Get a consistent copy of the latest stored value
+         */
+        T load() const noexcept {
+            T value;
+            while(not try_load(value)) detail::cpu_relax();
+            return value;
+        }
+
+        /**
+         * \brief Make one attempt to copy the latest stored value
+         *
+         * \param[out] The copy, only valid if true is returned
+         *
+         * \return bool : false if a store was in progress
+         */
+        bool try_load(T& value) const noexcept {
+            auto before = m_seq.load(std::memory_order_acquire);
+            if(before & 1) return false;
+            read_words(value);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return m_seq.load(std::memory_order_relaxed) == before;
+        }
+
+        void store(const T& value) noexcept {
+            auto seq = lock();
+            write_words(value);
+            m_seq.store(seq + 2, std::memory_order_release);
+        }
+
+        /**
+         * \brief Modify the value in place
+         *
+         * \param[in] A functor taking a T& to update. It's invoked while
+         *            other stores wait, so keep it short.
+         *
+         * \return decltype(in)
+         */
+        template<class Func>
+        decltype(auto) update(Func&& func) {
+            auto seq = lock();
+            T value;
+            read_words(value);
+            unlocker unlock{*this, seq};
+            struct writer {
+                ~writer() { sl.write_words(value); }
+                seqlock& sl;
+                T& value;
+            } write{*this, value};
+            return func(value);
+        }
+
+    private:
+        static constexpr std::size_t word_count = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+        struct unlocker {
+            ~unlocker() { sl.m_seq.store(seq + 2, std::memory_order_release); }
+            seqlock& sl;
+            std::uint64_t seq;
+        };
+
+        // makes the sequence odd, returns the even sequence it had before
+        std::uint64_t lock() noexcept {
+            auto seq = m_seq.load(std::memory_order_relaxed);
+            while(true) {
+                if(seq & 1) {
+                    detail::cpu_relax();
+                    seq = m_seq.load(std::memory_order_relaxed);
+                } else if(m_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                                      std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            // the data stores must not become visible before the odd sequence
+            std::atomic_thread_fence(std::memory_order_release);
+            return seq;
+        }
+
+        // The value is kept in relaxed atomic words so that a reader racing
+        // with a writer reads garbage, which is then discarded, instead of
+        // causing undefined behavior.
+        void read_words(T& value) const noexcept {
+            std::uint64_t words[word_count];
+            for(std::size_t i = 0; i < word_count; ++i) words[i] = m_words[i].load(std::memory_order_relaxed);
+            std::memcpy(&value, words, sizeof(T));
+        }
+        void write_words(const T& value) noexcept {
+            std::uint64_t words[word_count]{};
+            std::memcpy(words, &value, sizeof(T));
+            for(std::size_t i = 0; i < word_count; ++i) m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        std::atomic<std::uint64_t> m_seq{0};
+        std::atomic<std::uint64_t> m_words[word_count];
+    };
+
+    // -------------------------------------------------------------------------
+    /**
+     * \brief A wait-free triple buffer for one writer thread and one reader
+     *        thread, for objects too large to copy on every read
+     *
+     * The writer fills the back buffer and publishes it by swapping it with
+     * the middle buffer. The reader swaps its front buffer with the middle
+     * buffer when a new one has been published and reads the front buffer in
+     * place. Neither side ever waits for the other. Intermediate values are
+     * skipped if the writer publishes faster than the reader reads.
+     *
+     * For more than one reader thread, use one triple_buffer per reader.
+     */
+    template<class T>
+    class triple_buffer {
+    public:
+        using value_type = T;
+
+        triple_buffer() = default;
+        explicit triple_buffer(const T& value) : m_buffers{{value}, {value}, {value}} {}
+        triple_buffer(const triple_buffer&) = delete;            // no copies
+        triple_buffer& operator=(const triple_buffer&) = delete; // no copies
+
+        // writer side ---------------------------------------------------------
+
+        /**
+         * \brief The back buffer, owned by the writer until publish()
+         *
+         * Note: It contains the value published two publish() calls ago,
+         *       or older, not the latest published value.
+         */
+        inline T& write_buffer() noexcept { return m_buffers[m_back].value; }
+
+        // makes the back buffer the latest value
+        void publish() noexcept { m_back = m_middle.exchange(m_back | fresh, std::memory_order_acq_rel) & index_mask; }
+
+        void write(const T& value) {
+            write_buffer() = value;
+            publish();
+        }
+        void write(T&& value) {
+            write_buffer() = std::move(value);
+            publish();
+        }
+
+        // reader side ---------------------------------------------------------
+
+        /**
+         * \brief The latest published value
+         *
+         * The reference stays valid until the next call to read().
+         */
+        const T& read() noexcept {
+            if(m_middle.load(std::memory_order_relaxed) & fresh)
+                m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & index_mask;
+            return m_buffers[m_front].value;
+        }
+
+        // true if read() would return a newer value than last time
+        inline bool updated() const noexcept { return m_middle.load(std::memory_order_relaxed) & fresh; }
+
+    private:
+        static constexpr unsigned index_mask = 3;
+        static constexpr unsigned fresh = 4; // the middle buffer has not been read
+
+        struct alignas(64) buffer {
+            T value;
+        };
+
+        buffer m_buffers[3]{};
+        alignas(64) std::atomic<unsigned> m_middle{1};
+        alignas(64) unsigned m_back = 2; // the writer's
+        alignas(64) unsigned m_front = 0; // the reader's
+    };
+} // namespace thread
+} // namespace lyn
@@ -0,0 +1,261 @@
+#pragma once
+
+/*
+ * lyn::stopwatch, lyn::latency_histogram and lyn::scoped_timer
+ * Measuring durations in hot code. The histogram is lock-free: every thread
+ * records into its own shard and queries merge the shards.
+ *
+ * Requires C++20
+ */
+
+#include "lyn/log_watch.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lyn {
+
+// -----------------------------------------------------------------------------
+template<class Precision = std::chrono::microseconds, class Clock = std::chrono::steady_clock>
+class stopwatch {
+public:
+    using precision_type = Precision;
+    using clock_type = Clock;
+    using time_point = typename Clock::time_point;
+
+    stopwatch() : m_start(Clock::now()) {}
+
+    inline void restart() { m_start = Clock::now(); }
+    inline Precision elapsed() const { return std::chrono::duration_cast<Precision>(Clock::now() - m_start); }
+
+    // returns the elapsed time and restarts the stopwatch
+    inline Precision lap() {
+        auto now = Clock::now();
+        auto res = std::chrono::duration_cast<Precision>(now - m_start);
+        m_start = now;
+        return res;
+    }
+
+private:
+    time_point m_start;
+};
+
+namespace detail {
+    template<class Precision>
+    constexpr const char* unit_suffix() {
+        using period = typename Precision::period;
+        if(std::ratio_equal<period, std::nano>::value) return "ns";
+        if(std::ratio_equal<period, std::micro>::value) return "us";
+        if(std::ratio_equal<period, std::milli>::value) return "ms";
+        if(std::ratio_equal<period, std::ratio<1>>::value) return "s";
+        if(std::ratio_equal<period, std::ratio<60>>::value) return "min";
+        if(std::ratio_equal<period, std::ratio<3600>>::value) return "h";
+        return "ticks";
+    }
+
+    inline std::uint64_t next_histogram_id() {
+        static std::atomic<std::uint64_t> id{1};
+        return id.fetch_add(1, std::memory_order_relaxed);
+    }
+} // namespace detail
+
+// -----------------------------------------------------------------------------
+// A log-linear (HDR style) histogram of durations counted in Precision ticks.
+// Every power of two range is split in 2^SubBucketBits buckets, which gives a
+// relative error of at most 2^-SubBucketBits over the whole 64 bit range.
+//
+// record() only does relaxed loads and stores on memory owned by the calling
+// thread. snapshot() and summary() may be called from any thread.
+template<class Precision = std::chrono::microseconds, class Clock = std::chrono::steady_clock,
+         std::size_t SubBucketBits = 5>
+class latency_histogram {
+public:
+    using precision_type = Precision;
+    using clock_type = Clock;
+
+    static constexpr std::size_t sub_buckets = std::size_t(1) << SubBucketBits;
+    static constexpr std::size_t bucket_count = (65 - SubBucketBits) * sub_buckets;
+
+    static_assert(SubBucketBits > 0 && SubBucketBits < 16, "SubBucketBits out of range");
+
+    static constexpr std::size_t index_of(std::uint64_t value) noexcept {
+        std::size_t msb = value ? static_cast<std::size_t>(std::bit_width(value)) - 1 : 0;
+        std::size_t shift = msb > SubBucketBits ? msb - SubBucketBits : 0;
+        return shift * sub_buckets + static_cast<std::size_t>(value >> shift);
+    }
+    // the highest value that ends up in the bucket at index
+    static constexpr std::uint64_t highest_value_of(std::size_t index) noexcept {
+        if(index < 2 * sub_buckets) return index;
+        std::size_t shift = index / sub_buckets - 1;
+        std::uint64_t mantissa = index - shift * sub_buckets;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    // the merged result of all shards
+    class snapshot_type {
+    public:
+        inline std::uint64_t count() const { return m_count; }
+        inline Precision min() const { return Precision(m_count ? m_min : 0); }
+        inline Precision max() const { return Precision(m_max); }
+        inline Precision mean() const { return Precision(m_count ? m_sum / m_count : 0); }
+
+        // p in [0, 100]
+        Precision percentile(double p) const {
+            if(m_count == 0) return Precision(0);
+            auto rank = static_cast<std::uint64_t>(p / 100.0 * static_cast<double>(m_count) + 0.5);
+            if(rank == 0) rank = 1;
+            if(rank > m_count) rank = m_count;
+            std::uint64_t seen = 0;
+            for(std::size_t i = 0; i < bucket_count; ++i) {
+                seen += m_counts[i];
+                if(seen >= rank) {
+                    auto value = highest_value_of(i);
+                    return Precision(value < m_max ? value : m_max);
+                }
+            }
+            return max();
+        }
+
+    private:
+        friend class latency_histogram;
+        std::vector<std::uint64_t> m_counts = std::vector<std::uint64_t>(bucket_count);
+        std::uint64_t m_count = 0;
+        std::uint64_t m_sum = 0;
+        std::uint64_t m_min = UINT64_MAX;
+        std::uint64_t m_max = 0;
+    };
+
+    latency_histogram() = default;
+    latency_histogram(const latency_histogram&) = delete;            // no copies
+    latency_histogram& operator=(const latency_histogram&) = delete; // no copies
+    ~latency_histogram() {
+        for(shard* s = m_shards.load(); s;) delete std::exchange(s, s->next);
+    }
+
+    // The first record() in a thread allocates the thread's shard, which may
+    // throw std::bad_alloc. Call register_thread() first to have that happen
+    // elsewhere.
+    void record(Precision duration) {
+        auto value = duration.count() > 0 ? static_cast<std::uint64_t>(duration.count()) : std::uint64_t(0);
+        shard& s = local_shard();
+        bump(s.counts[index_of(value)], 1);
+        bump(s.count, 1);
+        bump(s.sum, value);
+        if(value < s.min.load(std::memory_order_relaxed)) s.min.store(value, std::memory_order_relaxed);
+        if(value > s.max.load(std::memory_order_relaxed)) s.max.store(value, std::memory_order_relaxed);
+    }
+    template<class Rep, class Period>
+    inline void record(std::chrono::duration<Rep, Period> duration) {
+        record(std::chrono::duration_cast<Precision>(duration));
+    }
+
+    // makes sure the calling thread has a shard so that record() won't allocate
+    inline void register_thread() { local_shard(); }
+
+    snapshot_type snapshot() const {
+        snapshot_type res;
+        for(shard* s = m_shards.load(std::memory_order_acquire); s; s = s->next) {
+            for(std::size_t i = 0; i < bucket_count; ++i) res.m_counts[i] += s->counts[i].load(std::memory_order_relaxed);
+            res.m_count += s->count.load(std::memory_order_relaxed);
+            res.m_sum += s->sum.load(std::memory_order_relaxed);
+            auto mi = s->min.load(std::memory_order_relaxed);
+            auto ma = s->max.load(std::memory_order_relaxed);
+            if(mi < res.m_min) res.m_min = mi;
+            if(ma > res.m_max) res.m_max = ma;
+        }
+        return res;
+    }
+
+    // A printable summary, prefixed by the time it was taken formatted by a
+    // log_watch<std::chrono::microseconds>, whatever the Precision:
+    // 2021-01-01T12:00:00.123456 count=10 min=1us mean=2us p50=2us ... max=9us
+    struct summary_type {
+        snapshot_type snapshot;
+        std::chrono::system_clock::time_point taken;
+    };
+    summary_type summary() const { return {snapshot(), std::chrono::system_clock::now()}; }
+
+    friend std::ostream& operator<<(std::ostream& os, const summary_type& sum) {
+        static constexpr const char* unit = detail::unit_suffix<Precision>();
+        const auto& snap = sum.snapshot;
+        log_watch<std::chrono::microseconds> lw("%FT%T.");
+        os << lw(std::chrono::time_point_cast<std::chrono::microseconds>(sum.taken)) << " count=" << snap.count()
+           << " min=" << snap.min().count() << unit << " mean=" << snap.mean().count() << unit;
+        for(auto p : {50.0, 90.0, 99.0, 99.9}) os << " p" << p << '=' << snap.percentile(p).count() << unit;
+        return os << " max=" << snap.max().count() << unit;
+    }
+
+private:
+    struct shard {
+        std::array<std::atomic<std::uint64_t>, bucket_count> counts{};
+        std::atomic<std::uint64_t> count{};
+        std::atomic<std::uint64_t> sum{};
+        std::atomic<std::uint64_t> min{UINT64_MAX};
+        std::atomic<std::uint64_t> max{};
+        std::thread::id owner = std::this_thread::get_id();
+        shard* next = nullptr;
+    };
+
+    // single writer increment, no locked instruction needed
+    static inline void bump(std::atomic<std::uint64_t>& a, std::uint64_t v) noexcept {
+        a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+
+    shard& local_shard() {
+        // a small direct mapped per thread cache of the shards used by this thread
+        struct cache_entry {
+            std::uint64_t id;
+            shard* s;
+        };
+        thread_local std::array<cache_entry, 8> cache{};
+
+        auto& entry = cache[m_id % cache.size()];
+        if(entry.id == m_id) return *entry.s;
+
+        auto me = std::this_thread::get_id();
+        shard* s = m_shards.load(std::memory_order_acquire);
+        for(; s; s = s->next) {
+            if(s->owner == me) break;
+        }
+        if(s == nullptr) { // first use in this thread, push a new shard
+            s = new shard;
+            s->next = m_shards.load(std::memory_order_relaxed);
+            while(not m_shards.compare_exchange_weak(s->next, s, std::memory_order_release,
+                                                     std::memory_order_relaxed)) {}
+        }
+        entry = {m_id, s};
+        return *s;
+    }
+
+    const std::uint64_t m_id = detail::next_histogram_id();
+    std::atomic<shard*> m_shards{nullptr};
+};
+
+// -----------------------------------------------------------------------------
+// Records the lifetime of the scoped_timer in a latency_histogram. The
+// constructor registers the thread in the histogram so that recording in the
+// destructor doesn't allocate.
+template<class Precision, class Clock, std::size_t SubBucketBits>
+class scoped_timer {
+public:
+    using histogram_type = latency_histogram<Precision, Clock, SubBucketBits>;
+
+    explicit scoped_timer(histogram_type& hist) : m_hist(hist) { m_hist.register_thread(); }
+    scoped_timer(const scoped_timer&) = delete;            // no copies
+    scoped_timer& operator=(const scoped_timer&) = delete; // no copies
+    ~scoped_timer() { m_hist.record(m_watch.elapsed()); }
+
+private:
+    histogram_type& m_hist;
+    stopwatch<Precision, Clock> m_watch;
+};
+
+} // namespace lyn
@@ -6,11 +6,33 @@
  * "This is free and unencumbered software released into the public domain."
 */
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <thread>
 #include <utility>
 
+#if __has_include(<sys/eventfd.h>)
+#    include <cerrno>
+#    include <cstdint>
+#    include <system_error>
+
+#    include <sys/eventfd.h>
+#    include <unistd.h>
+#    define LYN_HAS_EVENTFD 1
+#endif
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#    include "lyn/abstract_thread.hpp"
+#    include "lyn/executor.hpp"
+
+#    include <cstdint>
+#    include <functional>
+#    include <map>
+#    include <memory>
+#endif
+
 namespace lyn {
 namespace thread {
     // -------------------------------------------------------------------------
@@ -60,6 +82,205 @@ namespace thread {
         return func();
     }
     // -------------------------------------------------------------------------
+    namespace detail {
+        // tells the CPU that we are busy waiting
+        inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#else
+            std::this_thread::yield();
+#endif
+        }
+
+        // the number of times to spin before sleeping, none on a single CPU
+        inline int spin_limit() noexcept {
+            static const int limit = std::thread::hardware_concurrency() > 1 ? 128 : 0;
+            return limit;
+        }
+
+        // Busy waits a short while for pred() to become true before falling
+        // back on waiting for cvmtx. Whoever makes pred() true must do so
+        // with cvmtx.mtx locked and then notify cvmtx.cv.
+        template<class Pred>
+        void spin_then_wait(cv_mtx_pair& cvmtx, Pred&& pred) {
+            for(int i = spin_limit(); i > 0; --i) {
+                if(pred()) return;
+                cpu_relax();
+            }
+            std::unique_lock<std::mutex> lock(cvmtx.mtx);
+            while(not pred()) cvmtx.cv.wait(lock);
+        }
+
+        // A suspended coroutine in a waiter_list, resume() posts it to its
+        // executor. Neither depends on <coroutine> so event and message_queue
+        // have the same layout, and release waiters the same way, in
+        // translation units compiled with and without coroutine support.
+        struct waiter_hook {
+            waiter_hook* prev = nullptr;
+            waiter_hook* next = nullptr;
+            bool linked = false;
+            void (*resume)(waiter_hook&) = nullptr;
+        };
+
+        // an intrusive FIFO list of suspended coroutines
+        class waiter_list {
+        public:
+            inline bool empty() const noexcept { return m_head == nullptr; }
+
+            void push_back(waiter_hook* node) noexcept {
+                node->prev = m_tail;
+                node->next = nullptr;
+                node->linked = true;
+                if(m_tail)
+                    m_tail->next = node;
+                else
+                    m_head = node;
+                m_tail = node;
+            }
+            waiter_hook* pop_front() noexcept {
+                waiter_hook* node = m_head;
+                if(node) erase(node);
+                return node;
+            }
+            void erase(waiter_hook* node) noexcept {
+                if(node->prev)
+                    node->prev->next = node->next;
+                else
+                    m_head = node->next;
+                if(node->next)
+                    node->next->prev = node->prev;
+                else
+                    m_tail = node->prev;
+                node->prev = node->next = nullptr;
+                node->linked = false;
+            }
+
+        private:
+            waiter_hook* m_head = nullptr;
+            waiter_hook* m_tail = nullptr;
+        };
+
+        // resumes the waiters when destroyed, after the locks have been released
+        struct waiter_resumer {
+            ~waiter_resumer() {
+                while(auto waiter = waiters.pop_front()) waiter->resume(*waiter);
+            }
+            waiter_list waiters;
+        };
+    } // namespace detail
+    // -------------------------------------------------------------------------
+#ifdef LYN_HAS_EVENTFD
+    // Tag selecting the eventfd notification mode of event and message_queue
+    struct use_eventfd_t {
+        explicit use_eventfd_t() = default;
+    };
+    constexpr use_eventfd_t use_eventfd{};
+
+    namespace detail {
+        // An optional non-blocking eventfd used as a pollable flag
+        class eventfd_handle {
+        public:
+            eventfd_handle() = default;
+            explicit eventfd_handle(use_eventfd_t) : m_fd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+                if(m_fd == -1) throw std::system_error(errno, std::generic_category(), "eventfd");
+            }
+            eventfd_handle(const eventfd_handle&) = delete;            // no copies
+            eventfd_handle& operator=(const eventfd_handle&) = delete; // no copies
+            eventfd_handle(eventfd_handle&& other) noexcept : m_fd(std::exchange(other.m_fd, -1)) {}
+            eventfd_handle& operator=(eventfd_handle&& other) noexcept {
+                std::swap(m_fd, other.m_fd);
+                return *this;
+            }
+            ~eventfd_handle() {
+                if(m_fd != -1) ::close(m_fd);
+            }
+
+            inline explicit operator bool() const noexcept { return m_fd != -1; }
+            inline int fd() const noexcept { return m_fd; }
+
+            // make the fd readable
+            void signal() const noexcept {
+                std::uint64_t one = 1;
+                while(::write(m_fd, &one, sizeof one) == -1 && errno == EINTR) {}
+            }
+            // make the fd non-readable
+            void clear() const noexcept {
+                std::uint64_t value;
+                while(::read(m_fd, &value, sizeof value) == -1 && errno == EINTR) {}
+            }
+
+        private:
+            int m_fd = -1;
+        };
+    } // namespace detail
+    // -------------------------------------------------------------------------
+#endif
+#ifdef LYN_HAS_COROUTINES
+    namespace detail {
+        // Calls functors at given time points in a background thread. Used
+        // for the timeouts of the event awaitables.
+        class coroutine_timer final : public abstract_thread {
+        public:
+            static coroutine_timer& instance() {
+                static coroutine_timer timer;
+                return timer;
+            }
+            ~coroutine_timer() override {
+                guard_then_notify_using<notifier_of_one>(m_cvmtx, [this] { terminate(); });
+                join();
+            }
+
+            // identifies a scheduled functor, only useful as an argument to cancel()
+            using timer_id = std::pair<std::chrono::steady_clock::time_point, std::uint64_t>;
+
+            timer_id schedule(std::chrono::steady_clock::time_point tp, std::function<void()> func) {
+                return guard_then_notify_using<notifier_of_one>(m_cvmtx, [&] {
+                    timer_id id{tp, m_next_id++};
+                    m_timers.emplace(id, std::move(func));
+                    return id;
+                });
+            }
+
+            // removes the functor unless it has already been called or is being called
+            void cancel(const timer_id& id) {
+                std::lock_guard<std::mutex> lock(m_cvmtx.mtx);
+                m_timers.erase(id);
+            }
+
+            // the number of scheduled functors
+            std::size_t size() {
+                std::lock_guard<std::mutex> lock(m_cvmtx.mtx);
+                return m_timers.size();
+            }
+
+        private:
+            coroutine_timer() { start(); }
+
+            void execute() override {
+                std::unique_lock<std::mutex> lock(m_cvmtx.mtx);
+                while(not terminated()) {
+                    if(m_timers.empty()) {
+                        m_cvmtx.cv.wait(lock);
+                    } else if(m_timers.begin()->first.first <= std::chrono::steady_clock::now()) {
+                        auto func = std::move(m_timers.begin()->second);
+                        m_timers.erase(m_timers.begin());
+                        lock.unlock();
+                        func();
+                        lock.lock();
+                    } else {
+                        auto next = m_timers.begin()->first.first; // a copy, cancel() may erase the timer
+                        m_cvmtx.cv.wait_until(lock, next);
+                    }
+                }
+            }
+
+            cv_mtx_pair m_cvmtx;
+            std::map<timer_id, std::function<void()>> m_timers;
+            std::uint64_t m_next_id = 0;
+        };
+    } // namespace detail
+    // -------------------------------------------------------------------------
+#endif
     namespace detail {
         // partial specializations for manual / automatic reset event types
         template<bool, class T> struct event_impl;
@@ -97,7 +318,7 @@ namespace thread {
             using reset_notifier = notifier_of_all; // wait_for_reset needs this
 
             struct event_state_resetter {
-                ~event_state_resetter() { ev.m_state = false; }
+                ~event_state_resetter() { ev.set_state(false); }
                 T& ev;
             };
         };
@@ -114,6 +335,21 @@ namespace thread {
         using reset_notifier = typename impl::reset_notifier;
         using event_state_resetter = typename impl::event_state_resetter;
 
+        event() = default;
+#ifdef LYN_HAS_EVENTFD
+        /**
+         * \brief Create an event with a pollable file descriptor
+         *
+         * notification_fd() is readable while the event is signaled. When
+         * poll/epoll reports it as readable, use try_wait() (or wait()) to
+         * consume the state.
+         */
+        explicit event(use_eventfd_t tag) : m_efd(tag) {}
+
+        // the eventfd or -1 if the event was not created with use_eventfd
+        inline int notification_fd() const { return m_efd.fd(); }
+#endif
+
         /**
          * \brief Set the state to signaled
          *
@@ -127,9 +363,10 @@ namespace thread {
          */
         template<class Func = void(*)()>
         decltype(auto) set(Func&& func = []{}) {
+            detail::waiter_resumer resumer; // resumes released coroutines after the lock is released
             set_notifier notifier{m_cvmtx.cv};
             std::lock_guard<std::mutex> lock(m_cvmtx.mtx);
-            event_state_setter evs{*this};
+            event_state_setter evs{*this, true, &resumer.waiters};
             return func();
         }
 
@@ -155,6 +392,28 @@ namespace thread {
             return func();
         }
 
+        /**
+         * \brief Check if the state is signaled without waiting
+         *
+         * \param[in] An optional functor to invoke if the event is signaled
+         *            and while the event is locked
+         *
+         * \return bool : true:  The event was signaled and the optional
+         *                       functor was invoked.
+         *                false: The event was not signaled.
+         *
+         * event<true> : Sets the state to non-signaled if it was signaled.
+         */
+        template<class Func = void(*)()>
+        bool try_wait(Func&& func = []{}) {
+            reset_notifier notifier{m_cvmtx.cv};
+            std::lock_guard<std::mutex> lock(m_cvmtx.mtx);
+            if(not m_state) return false;
+            event_state_resetter evs{*this};
+            func();
+            return true;
+        }
+
         /**
          * \brief Perform a synchronized operation.
          *        Does not care about the state of the event.
@@ -219,16 +478,183 @@ namespace thread {
         }
 
     private:
+        // a coroutine suspended in async_wait / async_wait_until
+        struct async_waiter : detail::waiter_hook {
+            std::atomic<bool>* claimed = nullptr; // shared with the timer in timed waits
+            bool signaled = false;
+        };
+
+        // called with the lock held
+        void consume_state() {
+            if(AutoReset) {
+                set_state(false);
+                m_cvmtx.cv.notify_all(); // for wait_for_reset
+            }
+        }
+
+        // called with the lock held after the state has been set
+        void release_waiters(detail::waiter_list& released) {
+            while(m_state) {
+                auto waiter = static_cast<async_waiter*>(m_waiters.pop_front());
+                if(not waiter) break;
+                if(waiter->claimed && waiter->claimed->exchange(true)) continue; // timed out
+                waiter->signaled = true;
+                released.push_back(waiter);
+                consume_state();
+            }
+        }
+
+#ifdef LYN_HAS_COROUTINES
+        struct coroutine_waiter : async_waiter {
+            explicit coroutine_waiter(executor& executor) : ex(&executor) { this->resume = &post; }
+
+            // released by set(), a timed wait's timeout is no longer needed
+            static void post(detail::waiter_hook& hook) {
+                auto& self = static_cast<coroutine_waiter&>(hook);
+                if(self.claimed) detail::coroutine_timer::instance().cancel(self.timer);
+                self.ex->post(self.handle);
+            }
+
+            std::coroutine_handle<> handle;
+            executor* ex;
+            detail::coroutine_timer::timer_id timer{}; // of timed waits
+        };
+
+    public:
+        class async_wait_awaitable {
+        public:
+            async_wait_awaitable(event& ev, executor& ex) : m_ev(ev), m_waiter(ex) {}
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle) {
+                m_waiter.handle = handle;
+                std::lock_guard<std::mutex> lock(m_ev.m_cvmtx.mtx);
+                if(m_ev.m_state) {
+                    m_ev.consume_state();
+                    return false;
+                }
+                m_ev.m_waiters.push_back(&m_waiter);
+                return true;
+            }
+            void await_resume() const noexcept {}
+
+        private:
+            event& m_ev;
+            coroutine_waiter m_waiter;
+        };
+
+        class async_wait_until_awaitable {
+        public:
+            async_wait_until_awaitable(event& ev, std::chrono::steady_clock::time_point timeout_time, executor& ex) :
+                m_ev(ev), m_timeout_time(timeout_time), m_waiter(ex) {}
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle) {
+                m_waiter.handle = handle;
+                std::lock_guard<std::mutex> lock(m_ev.m_cvmtx.mtx);
+                if(m_ev.m_state) {
+                    m_ev.consume_state();
+                    m_waiter.signaled = true;
+                    return false;
+                }
+                // Whoever of set() and the timer that manages to claim the
+                // waiter resumes it. The timer only touches the event and
+                // the waiter if it wins, set() cancels the timer if it wins.
+                auto claimed = std::make_shared<std::atomic<bool>>(false);
+                m_waiter.claimed = claimed.get();
+                m_ev.m_waiters.push_back(&m_waiter);
+                m_waiter.timer = detail::coroutine_timer::instance().schedule(
+                    m_timeout_time, [claimed, ev = &m_ev, waiter = &m_waiter] {
+                        if(claimed->exchange(true)) return;
+                        {
+                            std::lock_guard<std::mutex> lock(ev->m_cvmtx.mtx);
+                            if(waiter->linked) ev->m_waiters.erase(waiter);
+                        }
+                        waiter->ex->post(waiter->handle);
+                    });
+                return true;
+            }
+            // true if the event was signaled, false on timeout
+            bool await_resume() const noexcept { return m_waiter.signaled; }
+
+        private:
+            event& m_ev;
+            std::chrono::steady_clock::time_point m_timeout_time;
+            coroutine_waiter m_waiter;
+        };
+
+        /**
+         * \brief co_await-able wait for the state to be signaled
+         *
+         * \param[in] The executor used to resume the coroutine when set()
+         *            releases it
+         *
+         * event<false> : set() releases all suspended coroutines
+         * event<true>  : set() releases one suspended coroutine and the state
+         *                is set to non-signaled
+         */
+        async_wait_awaitable async_wait(executor& ex = default_executor()) { return {*this, ex}; }
+
+        /**
+         * \brief co_await-able wait for the event to be signaled until a
+         *        certain time point
+         *
+         * \return bool : true:  The event was signaled before timeout_time
+         *                false: Waiting timed out
+         */
+        template<class Clock, class Duration>
+        async_wait_until_awaitable async_wait_until(const std::chrono::time_point<Clock, Duration>& timeout_time,
+                                                    executor& ex = default_executor()) {
+            return {*this, std::chrono::steady_clock::now() + (timeout_time - Clock::now()), ex};
+        }
+
+        /**
+         * \brief co_await-able wait for the event to be signaled for a
+         *        certain duration
+         *
+         * \return bool : true:  The event was signaled before rel_time
+         *                false: Waiting timed out
+         */
+        template<class Rep, class Period>
+        async_wait_until_awaitable async_wait_for(const std::chrono::duration<Rep, Period>& rel_time,
+                                                  executor& ex = default_executor()) {
+            return {*this,
+                    std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(rel_time),
+                    ex};
+        }
+#endif
+
+    private:
+        // called with the lock held
+        void set_state(bool state) {
+#ifdef LYN_HAS_EVENTFD
+            if(m_efd && state != m_state) {
+                if(state)
+                    m_efd.signal();
+                else
+                    m_efd.clear();
+            }
+#endif
+            m_state = state;
+        }
+
         struct event_state_setter {
             ~event_state_setter() {
-                ev.m_state = state;
+                ev.set_state(state);
+                if(released) ev.release_waiters(*released);
             }
             event& ev;
             bool state = true;
+            detail::waiter_list* released = nullptr; // set() releases suspended coroutines
         };
 
         cv_mtx_pair m_cvmtx;
         bool m_state = false;
+#ifdef LYN_HAS_EVENTFD
+        detail::eventfd_handle m_efd;
+#endif
+        detail::waiter_list m_waiters; // see detail::waiter_hook
     };
 
 } // namespace thread
@@ -0,0 +1,70 @@
+#pragma once
+
+/*
+ * lyn::thread::thread_pool
+ * An executor resuming coroutines in a fixed number of abstract_thread
+ * workers.
+ *
+ * Requires C++20
+ */
+
+#include "lyn/abstract_thread.hpp"
+#include "lyn/executor.hpp"
+#include "lyn/message_queue.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace lyn {
+namespace thread {
+    class thread_pool final : public executor {
+    public:
+        explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency()) {
+            if(threads == 0) threads = 1;
+            m_workers.reserve(threads);
+            for(std::size_t i = 0; i < threads; ++i) {
+                m_workers.emplace_back(std::make_unique<worker>(m_tasks));
+                m_workers.back()->start();
+            }
+        }
+        thread_pool(const thread_pool&) = delete;            // no copies
+        thread_pool& operator=(const thread_pool&) = delete; // no copies
+
+        // Coroutines that have not been resumed when the pool is destroyed
+        // are never resumed.
+        ~thread_pool() override {
+            m_tasks.shutdown();
+            m_workers.clear(); // joins
+        }
+
+        void post(std::coroutine_handle<> handle) override { m_tasks.push(handle); }
+
+        inline std::size_t size() const { return m_workers.size(); }
+
+    private:
+        class worker final : public abstract_thread {
+        public:
+            explicit worker(lyn::mq::message_queue<std::coroutine_handle<>>& tasks) : m_tasks(tasks) {}
+            ~worker() override { terminate_and_join(); }
+
+        protected:
+            void execute() override {
+                try {
+                    while(not terminated()) m_tasks.pop().resume();
+                } catch(const lyn::mq::message_queue_exception&) {
+                    // shutdown
+                }
+            }
+
+        private:
+            lyn::mq::message_queue<std::coroutine_handle<>>& m_tasks;
+        };
+
+        lyn::mq::message_queue<std::coroutine_handle<>> m_tasks;
+        std::vector<std::unique_ptr<worker>> m_workers;
+    };
+} // namespace thread
+} // namespace lyn
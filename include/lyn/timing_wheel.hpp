@@ -0,0 +1,371 @@
+#pragma once
+
+/*
+ * lyn::thread::timing_wheel
+ * A hierarchical hashed timing wheel. schedule and cancel are O(1) and
+ * lock-free, the wheel itself is only touched by its own thread which
+ * expires all timers due in a tick as one batch.
+ */
+
+#include "lyn/abstract_thread.hpp"
+#include "lyn/message_queue.hpp"
+#include "lyn/node_store.hpp"
+#include "lyn/thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace lyn {
+namespace thread {
+    // identifies a scheduled timer, only useful as an argument to cancel()
+    struct timer_id {
+        std::uint32_t index;
+        std::uint32_t generation;
+    };
+
+    // Timers are kept in 4 levels of 256 slots where the first level has the
+    // resolution of one tick, so the wheel covers 2^32 ticks (~50 days with
+    // 1 ms ticks). Timers further away than that are moved down when the top
+    // level slot expires. A timer never fires before its time point.
+    //
+    // Expired callbacks are collected per tick into a batch_type which is
+    // either run in the wheel's thread or pushed as one message onto a
+    // lyn::mq::message_queue<batch_type>. Like all abstract_threads, the wheel
+    // starts ticking when start() is called.
+    template<class Callback = std::function<void()>>
+    class timing_wheel final : public abstract_thread {
+    public:
+        using clock_type = std::chrono::steady_clock;
+        using callback_type = Callback;
+        using batch_type = std::vector<Callback>;
+
+        // Both constructors throw std::invalid_argument if tick isn't positive.
+        //
+        // runs the callbacks in the wheel's thread
+        explicit timing_wheel(std::chrono::nanoseconds tick = std::chrono::milliseconds(1)) :
+            m_tick(checked_tick(tick)), m_dispatch([](batch_type& batch) {
+                for(auto& cb : batch) cb();
+            }) {}
+        // pushes the callbacks of every tick with expired timers onto mq
+        explicit timing_wheel(lyn::mq::message_queue<batch_type>& mq,
+                              std::chrono::nanoseconds tick = std::chrono::milliseconds(1)) :
+            m_tick(checked_tick(tick)),
+            m_dispatch([&mq](batch_type& batch) {
+                try {
+                    mq.push(std::move(batch));
+                } catch(const lyn::mq::message_queue_exception&) {
+                    // the receiver is gone
+                }
+            }) {}
+        ~timing_wheel() override { shutdown(); }
+
+        // stops the wheel, timers that have not expired are discarded
+        void shutdown() {
+            terminate();
+            m_wakeup.set();
+            join();
+        }
+
+        template<class Duration>
+        timer_id schedule_at(const std::chrono::time_point<clock_type, Duration>& tp, Callback cb) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(tp - m_epoch).count();
+            std::uint64_t deadline = ns > 0 ? static_cast<std::uint64_t>((ns + m_tick - 1) / m_tick) : 0;
+
+            auto index = allocate();
+            node& n = at(index);
+            n.cb = std::move(cb);
+            n.deadline = deadline;
+            n.where = staged;
+            auto generation = n.gen_state.load(std::memory_order_relaxed) >> 2;
+            n.gen_state.store(generation << 2 | state_pending, std::memory_order_release);
+            push_stack(m_staged, index, &node::next_stack);
+
+            if(m_pending.fetch_add(1, std::memory_order_relaxed) == 0) m_wakeup.set(); // may be idle
+            return {index, static_cast<std::uint32_t>(generation)};
+        }
+        template<class Rep, class Period>
+        inline timer_id schedule_after(const std::chrono::duration<Rep, Period>& rel_time, Callback cb) {
+            return schedule_at(clock_type::now() + rel_time, std::move(cb));
+        }
+
+        // returns true if the timer was cancelled before it expired
+        bool cancel(timer_id id) {
+            if(id.index >= m_nodes.size()) return false;
+            node& n = at(id.index);
+            auto expected = std::uint64_t(id.generation) << 2 | state_pending;
+            if(not n.gen_state.compare_exchange_strong(expected, expected - state_pending + state_cancelled,
+                                                       std::memory_order_acq_rel)) {
+                return false;
+            }
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+            push_stack(m_cancelled, id.index, &node::next_cancelled); // let the wheel unlink it
+            return true;
+        }
+
+        // the number of scheduled timers that have neither expired nor been cancelled
+        inline std::size_t pending() const { return m_pending.load(std::memory_order_relaxed); }
+
+#ifdef LYN_HAS_COROUTINES
+        // co_await wheel.async_sleep_until(tp, ex) resumes the coroutine via
+        // ex when tp has passed
+        struct sleep_awaitable {
+            timing_wheel& wheel;
+            clock_type::time_point tp;
+            executor& ex;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                wheel.schedule_at(tp, [&ex = ex, handle] { ex.post(handle); });
+            }
+            void await_resume() const noexcept {}
+        };
+        template<class Duration>
+        sleep_awaitable async_sleep_until(const std::chrono::time_point<clock_type, Duration>& tp,
+                                          executor& ex = default_executor()) {
+            return {*this, std::chrono::time_point_cast<clock_type::duration>(tp), ex};
+        }
+        template<class Rep, class Period>
+        sleep_awaitable async_sleep_for(const std::chrono::duration<Rep, Period>& rel_time,
+                                        executor& ex = default_executor()) {
+            return async_sleep_until(clock_type::now() + rel_time, ex);
+        }
+#endif
+
+    protected:
+        void execute() override {
+            batch_type batch;
+            while(not terminated()) {
+                auto now = tick_of(clock_type::now());
+                if(m_linked == 0 && m_current < now) m_current = now; // nothing to expire on the way
+
+                take_staged(batch);
+                take_cancelled();
+                while(m_current < now) {
+                    ++m_current;
+                    expire_tick(batch);
+                }
+                if(not batch.empty()) {
+                    m_dispatch(batch);
+                    batch.clear();
+                }
+
+                if(m_linked == 0 && m_staged.load(std::memory_order_acquire) == nil)
+                    m_wakeup.wait_for(std::chrono::milliseconds(100)); // idle, schedule_at wakes us up
+                else
+                    m_wakeup.wait_until(m_epoch + std::chrono::nanoseconds(static_cast<std::int64_t>(m_current + 1) *
+                                                                           m_tick));
+            }
+        }
+
+    private:
+        static constexpr std::uint32_t nil = UINT32_MAX;
+        static constexpr unsigned levels = 4;
+        static constexpr unsigned slot_bits = 8;
+        static constexpr std::uint64_t slots = std::uint64_t(1) << slot_bits;
+        static constexpr std::uint64_t slot_mask = slots - 1;
+
+        // the state in the low bits of node::gen_state
+        static constexpr std::uint64_t state_unused = 0, state_pending = 1, state_cancelled = 2, state_fired = 3;
+        // where a node is, as seen by the wheel's thread
+        enum location : unsigned char { staged, linked, orphan, cancel_seen };
+
+        static std::int64_t checked_tick(std::chrono::nanoseconds tick) {
+            if(tick.count() <= 0) throw std::invalid_argument("timing_wheel: tick must be positive");
+            return tick.count();
+        }
+
+        struct link {
+            link* prev = this;
+            link* next = this;
+        };
+
+        struct node : link {
+            Callback cb{};
+            std::uint64_t deadline = 0; // in ticks since m_epoch
+            // the generation, so that cancel() can't hit a reused node, and the state
+            std::atomic<std::uint64_t> gen_state{0};
+            std::atomic<std::uint32_t> next_stack{nil}; // the free list or the staged stack
+            std::atomic<std::uint32_t> next_cancelled{nil};
+            std::uint32_t index = 0;
+            location where = staged;
+        };
+
+        using store_type = lyn::detail::node_store<node, &node::next_stack, 10>;
+
+        inline node& at(std::uint32_t index) const noexcept { return m_nodes[index]; }
+
+        // ---------------------------------------------------------------------
+        // lock-free stacks of node indices. The free list, in m_nodes, is
+        // popped by any thread. The staged and cancelled stacks are only ever
+        // taken as a whole.
+        std::uint32_t allocate() {
+            auto index = m_nodes.pop();
+            while(index == nil) {
+                m_nodes.grow("timing_wheel: too many timers", [this](std::uint32_t begin, std::uint32_t count) {
+                    for(std::uint32_t i = 0; i < count; ++i) {
+                        node& n = m_nodes[begin + i];
+                        n.index = begin + i;
+                        n.next_stack.store(i + 1 < count ? begin + i + 1 : nil, std::memory_order_relaxed);
+                    }
+                    m_nodes.push(begin, begin + count - 1);
+                });
+                index = m_nodes.pop();
+            }
+            return index;
+        }
+        void release(node& n) { // the wheel's thread only
+            n.cb = Callback{};
+            auto generation = (n.gen_state.load(std::memory_order_relaxed) >> 2) + 1;
+            n.gen_state.store(generation << 2 | state_unused, std::memory_order_release);
+            m_nodes.push(n.index, n.index);
+        }
+
+        void push_stack(std::atomic<std::uint32_t>& head, std::uint32_t index,
+                        std::atomic<std::uint32_t> node::*next) noexcept {
+            auto& link_field = at(index).*next;
+            auto expected = head.load(std::memory_order_relaxed);
+            do {
+                link_field.store(expected, std::memory_order_relaxed);
+            } while(not head.compare_exchange_weak(expected, index, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+        }
+
+        // ---------------------------------------------------------------------
+        // the wheel, only used by the wheel's thread
+        std::uint64_t tick_of(clock_type::time_point tp) const noexcept {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(tp - m_epoch).count();
+            return ns > 0 ? static_cast<std::uint64_t>(ns / m_tick) : 0;
+        }
+
+        void take_staged(batch_type& batch) {
+            for(auto index = m_staged.exchange(nil, std::memory_order_acquire); index != nil;) {
+                node& n = at(index);
+                index = n.next_stack.load(std::memory_order_relaxed);
+                if((n.gen_state.load(std::memory_order_acquire) & 3) == state_cancelled) {
+                    if(n.where == cancel_seen)
+                        release(n);
+                    else
+                        n.where = orphan; // released when seen in the cancelled stack
+                } else {
+                    insert(n, batch);
+                }
+            }
+        }
+
+        void take_cancelled() {
+            for(auto index = m_cancelled.exchange(nil, std::memory_order_acquire); index != nil;) {
+                node& n = at(index);
+                index = n.next_cancelled.load(std::memory_order_relaxed);
+                switch(n.where) {
+                case linked:
+                    unlink(n);
+                    release(n);
+                    break;
+                case orphan:
+                    release(n);
+                    break;
+                default: // still in the staged stack
+                    n.where = cancel_seen;
+                }
+            }
+        }
+
+        void insert(node& n, batch_type& batch) {
+            if(n.deadline <= m_current) {
+                expire(n, batch);
+                return;
+            }
+            auto delta = n.deadline - m_current;
+            auto deadline = n.deadline;
+            unsigned level = 0;
+            while(level < levels - 1 && delta >= (std::uint64_t(1) << (slot_bits * (level + 1)))) ++level;
+            if(level == levels - 1 && delta >= (std::uint64_t(1) << (slot_bits * levels)))
+                deadline = m_current + (std::uint64_t(1) << (slot_bits * levels)) - 1; // rescheduled on the way
+
+            link& sentinel = m_wheel[level][(deadline >> (slot_bits * level)) & slot_mask];
+            n.prev = sentinel.prev;
+            n.next = &sentinel;
+            sentinel.prev->next = &n;
+            sentinel.prev = &n;
+            n.where = linked;
+            ++m_linked;
+        }
+
+        void unlink(node& n) noexcept {
+            n.prev->next = n.next;
+            n.next->prev = n.prev;
+            n.prev = n.next = &n;
+            --m_linked;
+        }
+
+        void expire(node& n, batch_type& batch) {
+            auto expected = n.gen_state.load(std::memory_order_relaxed);
+            if((expected & 3) == state_pending &&
+               n.gen_state.compare_exchange_strong(expected, expected - state_pending + state_fired,
+                                                   std::memory_order_acq_rel)) {
+                m_pending.fetch_sub(1, std::memory_order_relaxed);
+                batch.push_back(std::move(n.cb));
+                release(n);
+            } else {
+                n.where = orphan; // cancelled, released when seen in the cancelled stack
+            }
+        }
+
+        // moves all nodes in a slot to a temporary list
+        void take_slot(link& sentinel, link& out) noexcept {
+            if(sentinel.next == &sentinel) return;
+            out.next = sentinel.next;
+            out.prev = sentinel.prev;
+            out.next->prev = &out;
+            out.prev->next = &out;
+            sentinel.prev = sentinel.next = &sentinel;
+        }
+
+        void expire_tick(batch_type& batch) {
+            // cascade the higher levels whose slot boundary was just passed,
+            // highest level first, down to where they now belong
+            unsigned top = 0;
+            while(top < levels - 1 && ((m_current >> (slot_bits * (top + 1))) << (slot_bits * (top + 1))) == m_current)
+                ++top;
+            for(unsigned level = top; level > 0; --level) {
+                link taken;
+                take_slot(m_wheel[level][(m_current >> (slot_bits * level)) & slot_mask], taken);
+                while(taken.next != &taken) {
+                    node& n = static_cast<node&>(*taken.next);
+                    unlink(n);
+                    insert(n, batch);
+                }
+            }
+
+            link taken;
+            take_slot(m_wheel[0][m_current & slot_mask], taken);
+            while(taken.next != &taken) {
+                node& n = static_cast<node&>(*taken.next);
+                unlink(n);
+                expire(n, batch);
+            }
+        }
+
+        // ---------------------------------------------------------------------
+        const clock_type::time_point m_epoch = clock_type::now();
+        const std::int64_t m_tick; // in ns, > 0
+        std::function<void(batch_type&)> m_dispatch;
+        event<true> m_wakeup;
+
+        store_type m_nodes;
+        std::atomic<std::uint32_t> m_staged{nil};
+        std::atomic<std::uint32_t> m_cancelled{nil};
+        std::atomic<std::size_t> m_pending{0};
+
+        link m_wheel[levels][slots];
+        std::uint64_t m_current = 0; // the last expired tick
+        std::size_t m_linked = 0;    // nodes in the wheel, cancelled or not
+    };
+} // namespace thread
+} // namespace lyn
@@ -1,18 +1,242 @@
 #pragma once
 
+/*
+ * lyn::seq - compile time operations on std::integer_sequence
+ *
+ * The values of a sequence are copied into a constexpr array, operated on
+ * by constexpr functions and expanded back into a sequence with one pack
+ * expansion. No operation recurses over the values, so the instantiation
+ * depth does not grow with the length of the sequences and every operation
+ * instantiates a constant number of templates. (The depth of
+ * std::make_index_sequence is logarithmic or constant, depending on the
+ * standard library.)
+ *
+ * Requires C++14
+ */
+
 #include <cstddef>
-#include <tuple>
+#include <functional>
+#include <type_traits>
 #include <utility>
 
-namespace detail {
-    template <class T, T... I, std::size_t... J>
-    constexpr auto rev_helper(std::integer_sequence<T, I...>, std::index_sequence<J...>) {
-        //  <decltype(I)...>  below needed to make it work in C++14
-        return std::integer_sequence<T, std::get<sizeof...(J) - J - 1>(std::tuple<decltype(I)...>{I...})...>{};
+namespace lyn {
+namespace seq {
+    namespace detail {
+        // std::array::operator[] is not constexpr in C++14
+        template<class T, std::size_t N>
+        struct array {
+            T data[N == 0 ? 1 : N];
+        };
+
+        // the values of a sequence in a constexpr array
+        template<class Seq>
+        struct values;
+
+        template<class T, T... I>
+        struct values<std::integer_sequence<T, I...>> {
+            using value_type = T;
+            static constexpr std::size_t size = sizeof...(I);
+            static constexpr array<T, sizeof...(I)> value{{I...}};
+        };
+        template<class T, T... I>
+        constexpr array<T, sizeof...(I)> values<std::integer_sequence<T, I...>>::value;
+
+        // Gen::value is an array of Gen::size values to turn into a sequence
+        template<class T, class Gen, std::size_t... J>
+        std::integer_sequence<T, Gen::value.data[J]...> expand(std::index_sequence<J...>);
+
+        template<class T, class Gen>
+        using expand_t = decltype(expand<T, Gen>(std::make_index_sequence<Gen::size>{}));
+
+        // ---------------------------------------------------------------------
+        template<class T, T Begin, T End, T Step>
+        constexpr std::size_t range_size() {
+            static_assert(Step != 0, "make_integer_range: Step must not be 0");
+            if(Step > 0) return End > Begin ? static_cast<std::size_t>((End - Begin - 1) / Step) + 1 : 0;
+            return Begin > End ? static_cast<std::size_t>((Begin - End - 1) / -Step) + 1 : 0;
+        }
+
+        template<class T, T Begin, T Step, std::size_t... J>
+        std::integer_sequence<T, static_cast<T>(Begin + static_cast<T>(J) * Step)...> range(std::index_sequence<J...>);
+
+        // ---------------------------------------------------------------------
+        template<class V, std::size_t... J>
+        std::integer_sequence<typename V::value_type, V::value.data[V::size - 1 - J]...>
+            reverse(std::index_sequence<J...>);
+
+        template<class V, std::size_t Begin, std::size_t... J>
+        std::integer_sequence<typename V::value_type, V::value.data[Begin + J]...> slice(std::index_sequence<J...>);
+
+        // ---------------------------------------------------------------------
+        template<class... Vs>
+        constexpr std::size_t concat_size() {
+            const std::size_t sizes[] = {Vs::size...};
+            std::size_t res = 0;
+            for(std::size_t size : sizes) res += size;
+            return res;
+        }
+
+        template<class T, class... Vs>
+        constexpr array<T, concat_size<Vs...>()> concat_values() {
+            const T* sources[] = {Vs::value.data...};
+            const std::size_t sizes[] = {Vs::size...};
+            array<T, concat_size<Vs...>()> res{};
+            std::size_t pos = 0;
+            for(std::size_t s = 0; s < sizeof...(Vs); ++s) {
+                for(std::size_t i = 0; i < sizes[s]; ++i) res.data[pos++] = sources[s][i];
+            }
+            return res;
+        }
+
+        template<class T, class... Vs>
+        struct concat_gen {
+            static constexpr std::size_t size = concat_size<Vs...>();
+            static constexpr array<T, size> value = concat_values<T, Vs...>();
+        };
+        template<class T, class... Vs>
+        constexpr array<T, concat_gen<T, Vs...>::size> concat_gen<T, Vs...>::value;
+
+        // ---------------------------------------------------------------------
+        template<class V, class Pred>
+        constexpr std::size_t filter_size() {
+            std::size_t res = 0;
+            for(std::size_t i = 0; i < V::size; ++i) res += Pred{}(V::value.data[i]) ? 1 : 0;
+            return res;
+        }
+
+        template<class V, class Pred>
+        constexpr array<typename V::value_type, filter_size<V, Pred>()> filter_values() {
+            array<typename V::value_type, filter_size<V, Pred>()> res{};
+            std::size_t pos = 0;
+            for(std::size_t i = 0; i < V::size; ++i) {
+                if(Pred{}(V::value.data[i])) res.data[pos++] = V::value.data[i];
+            }
+            return res;
+        }
+
+        template<class V, class Pred>
+        struct filter_gen {
+            static constexpr std::size_t size = filter_size<V, Pred>();
+            static constexpr array<typename V::value_type, size> value = filter_values<V, Pred>();
+        };
+        template<class V, class Pred>
+        constexpr array<typename V::value_type, filter_gen<V, Pred>::size> filter_gen<V, Pred>::value;
+
+        // ---------------------------------------------------------------------
+        // a stable, bottom up, merge sort: O(N log N) constexpr operations
+        template<class V, class Compare>
+        constexpr array<typename V::value_type, V::size> sort_values() {
+            constexpr std::size_t n = V::size;
+            array<typename V::value_type, n> bufs[2]{V::value, {}};
+            std::size_t src = 0;
+            for(std::size_t width = 1; width < n; width *= 2, src ^= 1) {
+                auto& from = bufs[src].data;
+                auto& to = bufs[src ^ 1].data;
+                for(std::size_t lo = 0; lo < n; lo += 2 * width) {
+                    std::size_t mid = lo + width < n ? lo + width : n;
+                    std::size_t hi = mid + width < n ? mid + width : n;
+                    std::size_t l = lo, r = mid, out = lo;
+                    while(l < mid && r < hi) to[out++] = Compare{}(from[r], from[l]) ? from[r++] : from[l++];
+                    while(l < mid) to[out++] = from[l++];
+                    while(r < hi) to[out++] = from[r++];
+                }
+            }
+            return bufs[src];
+        }
+
+        template<class V, class Compare>
+        struct sort_gen {
+            static constexpr std::size_t size = V::size;
+            static constexpr array<typename V::value_type, size> value = sort_values<V, Compare>();
+        };
+        template<class V, class Compare>
+        constexpr array<typename V::value_type, sort_gen<V, Compare>::size> sort_gen<V, Compare>::value;
+
+        // ---------------------------------------------------------------------
+        template<class Seq, std::size_t Begin, std::size_t End>
+        struct slice_impl {
+            using V = values<Seq>;
+            static_assert(Begin <= End && End <= V::size, "slice_t: [Begin, End) out of range");
+            using type = decltype(slice<V, Begin>(std::make_index_sequence<End - Begin>{}));
+        };
+
+        template<std::size_t N>
+        constexpr bool all_of(const bool (&conditions)[N]) {
+            for(bool condition : conditions) {
+                if(not condition) return false;
+            }
+            return true;
+        }
+
+        template<class Seq, class... Seqs>
+        struct concat_impl {
+            using T = typename values<Seq>::value_type;
+            static_assert(all_of({true, std::is_same<T, typename values<Seqs>::value_type>::value...}),
+                          "concat_t: all sequences must have the same value_type");
+            using type = expand_t<T, concat_gen<T, values<Seq>, values<Seqs>...>>;
+        };
+    } // namespace detail
+
+    // -------------------------------------------------------------------------
+    // std::integer_sequence<T, Begin, Begin + Step, ...> up to, but not including, End
+    template<class T, T Begin, T End, T Step = 1>
+    using make_integer_range =
+        decltype(detail::range<T, Begin, Step>(std::make_index_sequence<detail::range_size<T, Begin, End, Step>()>{}));
+
+    template<std::size_t Begin, std::size_t End, std::size_t Step = 1>
+    using make_index_range = make_integer_range<std::size_t, Begin, End, Step>;
+
+    // the sequence in reverse order
+    template<class Seq>
+    using reverse_t = decltype(detail::reverse<detail::values<Seq>>(std::make_index_sequence<Seq::size()>{}));
+
+    // all sequences joined, they must have the same value_type
+    template<class Seq, class... Seqs>
+    using concat_t = typename detail::concat_impl<Seq, Seqs...>::type;
+
+    // the values in [Begin, End)
+    template<class Seq, std::size_t Begin, std::size_t End>
+    using slice_t = typename detail::slice_impl<Seq, Begin, End>::type;
+
+    // the values for which Pred{}(value) is true, Pred must be a literal type
+    // with a constexpr operator()
+    template<class Seq, class Pred>
+    using filter_t = detail::expand_t<typename Seq::value_type, detail::filter_gen<detail::values<Seq>, Pred>>;
+
+    // the values sorted by Compare{}, a stable sort
+    template<class Seq, class Compare = std::less<>>
+    using sort_t = detail::expand_t<typename Seq::value_type, detail::sort_gen<detail::values<Seq>, Compare>>;
+
+    // -------------------------------------------------------------------------
+    // function versions, for use on objects
+    template<class T, T... I>
+    constexpr reverse_t<std::integer_sequence<T, I...>> reverse(std::integer_sequence<T, I...>) {
+        return {};
+    }
+
+    template<class Seq, class... Seqs>
+    constexpr concat_t<Seq, Seqs...> concat(Seq, Seqs...) {
+        return {};
+    }
+
+    template<std::size_t Begin, std::size_t End, class T, T... I>
+    constexpr slice_t<std::integer_sequence<T, I...>, Begin, End> slice(std::integer_sequence<T, I...>) {
+        return {};
+    }
+
+    template<class Pred, class T, T... I>
+    constexpr filter_t<std::integer_sequence<T, I...>, Pred> filter(std::integer_sequence<T, I...>) {
+        return {};
+    }
+
+    template<class Compare = std::less<>, class T, T... I>
+    constexpr sort_t<std::integer_sequence<T, I...>, Compare> sort(std::integer_sequence<T, I...>) {
+        return {};
     }
-} // namespace detail
+} // namespace seq
+} // namespace lyn
 
-template <class T, T... I>
+template<class T, T... I>
 constexpr auto reverse_sequence(std::integer_sequence<T, I...> s) {
-    return detail::rev_helper(s, std::make_index_sequence<sizeof...(I)>{});
+    return lyn::seq::reverse(s);
 }
@@ -0,0 +1,48 @@
+#include "lyn/initialize.hpp"
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// lookup tables built at compile time
+
+constexpr auto primes = lyn::static_initialize<std::set<int>>(13, 2, 7, 3, 11, 5);
+
+constexpr auto status = lyn::static_initialize<std::map<int, std::string_view>>(
+    std::pair{404, "Not Found"}, std::pair{200, "OK"}, std::pair{500, "Internal Server Error"},
+    std::pair{301, "Moved Permanently"});
+
+constexpr auto keywords = lyn::static_initialize<std::unordered_map<std::string_view, int>>(
+    std::pair{"if", 1}, std::pair{"else", 2}, std::pair{"for", 3}, std::pair{"while", 4}, std::pair{"do", 5},
+    std::pair{"return", 6}, std::pair{"switch", 7}, std::pair{"case", 8}, std::pair{"break", 9});
+
+static_assert(primes.contains(11) && not primes.contains(4));
+static_assert(*primes.begin() == 2);
+static_assert(status.at(301) == "Moved Permanently");
+static_assert(keywords.at("while") == 4 && not keywords.contains("goto"));
+
+int main() {
+    // the runtime counterpart
+    auto vec = lyn::initialize<std::vector<int>>(1, 2, 3);
+    std::cout << "vector size " << vec.size() << '\n';
+
+    for(int p : primes) std::cout << p << ' ';
+    std::cout << '\n';
+
+    for(int code : {200, 301, 418}) {
+        if(auto it = status.find(code); it != status.end())
+            std::cout << code << ' ' << it->second << '\n';
+        else
+            std::cout << code << " unknown\n";
+    }
+
+    for(std::string_view word : {"for", "goto", "case"}) {
+        if(auto it = keywords.find(word); it != keywords.end())
+            std::cout << word << " => " << it->second << '\n';
+        else
+            std::cout << word << " is not a keyword\n";
+    }
+}
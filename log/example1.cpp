@@ -0,0 +1,20 @@
+#include "lyn/log_watch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+// log_watch example
+
+int main() {
+    using namespace std::chrono;
+
+    lyn::log_watch<milliseconds> lw("%FT%T.");
+    auto now = system_clock::now();
+
+    // streaming
+    std::cout << lw(now) << " streamed\n";
+
+    // formatting into a buffer
+    char buf[64];
+    std::cout.write(buf, static_cast<std::streamsize>(lw(now).format_to(buf, sizeof buf))) << " formatted\n";
+}
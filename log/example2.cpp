@@ -0,0 +1,26 @@
+#include "lyn/async_logger.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+// async_logger example
+
+int main() {
+    // log to stdout with room for 1024 messages in flight
+    lyn::async_logger<> logger(STDOUT_FILENO, 1024, lyn::overflow_policy::block);
+    logger.start();
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+        threads.emplace_back([&logger, t] {
+            for(int i = 0; i < 5; ++i) logger.log("thread ", t, " message ", i, " pi=", 3.14159);
+        });
+    }
+    for(auto& th : threads) th.join();
+
+    logger.log("a std::string is copied: ", std::string("hello"));
+
+    // writes everything logged so far before returning
+    logger.shutdown();
+}
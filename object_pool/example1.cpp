@@ -0,0 +1,29 @@
+#include "lyn/message_queue.hpp"
+#include "lyn/object_pool.hpp"
+
+#include <iostream>
+#include <string>
+#include <thread>
+
+int main() {
+    lyn::object_pool<std::string> pool;
+    lyn::mq::message_queue<lyn::pool_handle<std::string>> mq;
+
+    std::thread consumer([&] {
+        for(int i = 0; i < 10; ++i) {
+            auto msg = mq.pop();
+            std::cout << *msg << " (capacity " << msg->capacity() << ")\n";
+        } // msg is returned to the pool here
+    });
+
+    for(int i = 0; i < 10; ++i) {
+        auto msg = pool.acquire();
+        // a recycled string keeps its buffer, assign to it
+        msg->assign("message number ");
+        msg->append(std::to_string(i));
+        mq.push(std::move(msg));
+    }
+    consumer.join();
+
+    std::cout << "the pool created " << pool.size() << " strings\n";
+}
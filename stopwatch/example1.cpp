@@ -0,0 +1,38 @@
+#include "lyn/stopwatch.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// latency_histogram and scoped_timer example
+
+lyn::latency_histogram<std::chrono::nanoseconds> hist;
+
+double work(int n) {
+    double sum = 0;
+    for(int i = 1; i <= n; ++i) sum += std::sqrt(static_cast<double>(i));
+    return sum;
+}
+
+int main() {
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            double sum = 0;
+            for(int i = 0; i < 10000; ++i) {
+                lyn::scoped_timer timer(hist); // records when it goes out of scope
+                sum += work(i % 100);
+            }
+            if(sum < 0) std::cout << sum;
+        });
+    }
+    for(auto& th : threads) th.join();
+
+    std::cout << hist.summary() << '\n';
+
+    lyn::stopwatch<std::chrono::microseconds> sw;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    std::cout << "slept " << sw.elapsed().count() << "us\n";
+}
@@ -0,0 +1,42 @@
+#include "lyn/barrier.hpp"
+
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// barrier / latch example: workers summing their part of a vector in three
+// rounds with the partial results merged by the barrier's completion functor
+
+int main() {
+    constexpr int workers = 4;
+    std::vector<int> values(1000);
+    std::iota(values.begin(), values.end(), 1);
+
+    std::vector<long> partial(workers);
+    long total = 0;
+    int round = 0;
+
+    // invoked by the last worker to arrive in every round, before any worker continues
+    lyn::thread::barrier<std::function<void()>> round_done(workers, [&] {
+        total += std::accumulate(partial.begin(), partial.end(), 0L);
+        std::cout << "round " << ++round << " total " << total << '\n';
+    });
+    lyn::thread::latch all_done(workers);
+
+    std::vector<std::thread> threads;
+    for(int w = 0; w < workers; ++w) {
+        threads.emplace_back([&, w] {
+            for(int r = 0; r < 3; ++r) {
+                auto chunk = values.size() / workers;
+                partial[w] = std::accumulate(values.begin() + w * chunk, values.begin() + (w + 1) * chunk, 0L);
+                round_done.arrive_and_wait();
+            }
+            all_done.count_down();
+        });
+    }
+    all_done.wait();
+    std::cout << "all done\n";
+    for(auto& th : threads) th.join();
+}
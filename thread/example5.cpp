@@ -0,0 +1,49 @@
+#include "lyn/message_queue.hpp"
+#include "lyn/thread.hpp"
+#include "lyn/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// coroutine example (C++20)
+
+lyn::thread::thread_pool pool(2);
+lyn::mq::message_queue<std::string> mq;
+lyn::thread::event<false> done; // false = manual reset
+std::atomic<int> consumed{};
+
+lyn::thread::detached_task consumer(int id) {
+    try {
+        while(true) {
+            // suspends without blocking a thread, resumed in the pool by push()
+            auto msg = co_await mq.async_pop(pool);
+            std::cout << "consumer " << id << ": " << msg << '\n';
+            if(++consumed == 6) done.set();
+        }
+    } catch(const lyn::mq::message_queue_exception&) {
+        std::cout << "consumer " << id << ": shutdown\n";
+    }
+}
+
+lyn::thread::detached_task waiter() {
+    bool signaled = co_await done.async_wait_for(std::chrono::milliseconds(10), pool);
+    std::cout << "waiter: " << (signaled ? "signaled" : "timed out") << '\n';
+
+    co_await done.async_wait(pool);
+    std::cout << "waiter: all messages consumed\n";
+}
+
+int main() {
+    for(int id = 0; id < 3; ++id) consumer(id);
+    waiter();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for(int i = 0; i < 6; ++i) mq.push("message " + std::to_string(i));
+
+    done.wait();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    mq.shutdown();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
@@ -0,0 +1,55 @@
+#include "lyn/message_queue.hpp"
+#include "lyn/thread.hpp"
+
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/epoll.h>
+
+// eventfd example: a thread waiting in epoll_wait for both a message_queue
+// and an event (they could be sockets too)
+
+lyn::mq::message_queue<std::string> mq(lyn::thread::use_eventfd);
+lyn::thread::event<true> quit(lyn::thread::use_eventfd); // true = auto reset
+
+void a_thread() {
+    for(int i = 0; i < 5; ++i) mq.push("message " + std::to_string(i)); // only the first push writes the eventfd
+    quit.set();
+}
+
+int main() {
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    for(int fd : {mq.notification_fd(), quit.notification_fd()}) {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    auto th = std::thread(a_thread);
+
+    bool running = true;
+    while(running) {
+        epoll_event events[2];
+        int count = epoll_wait(ep, events, 2, -1);
+        for(int i = 0; i < count; ++i) {
+            if(events[i].data.fd == mq.notification_fd()) {
+                lyn::mq::message_queue<std::string>::queue_t msgs;
+                if(mq.pop_all(msgs)) { // reads the eventfd since the queue is left empty
+                    std::cout << "got " << msgs.size() << " message(s)\n";
+                    for(; not msgs.empty(); msgs.pop()) std::cout << "  " << msgs.front() << '\n';
+                }
+            } else if(quit.try_wait()) { // resets the event and reads the eventfd
+                std::cout << "quit\n";
+                running = false;
+            }
+        }
+    }
+    // pick up anything pushed after the last epoll_wait
+    lyn::mq::message_queue<std::string>::queue_t msgs;
+    if(mq.pop_all(msgs)) std::cout << "got " << msgs.size() << " late message(s)\n";
+
+    th.join();
+    close(ep);
+}
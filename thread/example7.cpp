@@ -0,0 +1,29 @@
+#include "lyn/broadcast_queue.hpp"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// broadcast_queue example: one producer, three subscribers that all see every message
+
+int main() {
+    lyn::mq::broadcast_queue<std::string> bq(16); // slow_subscriber_policy::block
+
+    std::vector<std::thread> threads;
+    for(int id = 0; id < 3; ++id) {
+        // subscribe before pushing to not miss any messages
+        threads.emplace_back([id, sub = bq.subscribe()]() mutable {
+            while(true) {
+                auto v = sub.next();
+                if(v->empty()) break; // end marker
+                std::cout << "subscriber " + std::to_string(id) + " got " + *v + '\n';
+            }
+        });
+    }
+
+    for(int i = 0; i < 5; ++i) bq.push("message " + std::to_string(i));
+    bq.push("");
+
+    for(auto& th : threads) th.join();
+}
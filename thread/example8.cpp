@@ -0,0 +1,39 @@
+#include "lyn/timing_wheel.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// timing_wheel example: the expired timers are run by a worker thread that
+// gets them, one batch per tick, via a message_queue
+
+using wheel_type = lyn::thread::timing_wheel<>;
+
+int main() {
+    lyn::mq::message_queue<wheel_type::batch_type> mq;
+    wheel_type wheel(mq);
+    wheel.start();
+
+    auto worker = std::thread([&mq] {
+        try {
+            while(true) {
+                for(auto& callback : mq.pop()) callback();
+            }
+        } catch(const lyn::mq::message_queue_exception&) {
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for(int ms : {300, 100, 200}) {
+        wheel.schedule_at(start + std::chrono::milliseconds(ms),
+                          [ms] { std::cout << "timer " + std::to_string(ms) + " ms\n"; });
+    }
+    auto id = wheel.schedule_after(std::chrono::milliseconds(150), [] { std::cout << "never\n"; });
+    std::cout << "cancelled: " << std::boolalpha << wheel.cancel(id) << '\n';
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    wheel.shutdown();
+    mq.shutdown();
+    worker.join();
+}
@@ -0,0 +1,36 @@
+#include "lyn/seqlock.hpp"
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+// seqlock / triple_buffer example: a writer publishing small limits via a
+// seqlock and a larger routing table via a triple_buffer
+
+struct limits {
+    int max_connections;
+    double max_rate;
+};
+
+using routing_table = std::map<std::string, std::string>;
+
+int main() {
+    lyn::thread::seqlock<limits> current_limits(limits{100, 10.0});
+    lyn::thread::triple_buffer<routing_table> routes;
+
+    auto writer = std::thread([&] {
+        for(int i = 1; i <= 3; ++i) {
+            current_limits.update([i](limits& l) { l.max_connections = 100 * (i + 1); });
+
+            routing_table& table = routes.write_buffer(); // not the latest published table
+            table = {{"/api", "backend" + std::to_string(i)}, {"/static", "cdn"}};
+            routes.publish();
+        }
+    });
+    writer.join();
+
+    auto l = current_limits.load();
+    std::cout << "max_connections=" << l.max_connections << " max_rate=" << l.max_rate << '\n';
+    for(auto& [prefix, target] : routes.read()) std::cout << prefix << " -> " << target << '\n';
+}
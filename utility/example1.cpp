@@ -0,0 +1,30 @@
+#include "lyn/utility.hpp"
+
+#include <iostream>
+#include <utility>
+
+struct is_even {
+    constexpr bool operator()(int v) const { return v % 2 == 0; }
+};
+
+template<class T, T... I>
+void print(const char* name, std::integer_sequence<T, I...>) {
+    std::cout << name << ":";
+    int dummy[] = {0, (std::cout << ' ' << I, 0)...};
+    static_cast<void>(dummy);
+    std::cout << '\n';
+}
+
+int main() {
+    using namespace lyn::seq;
+
+    using evens = filter_t<make_integer_range<int, 0, 10>, is_even>;
+    using odds = make_integer_range<int, 9, 0, -2>;
+
+    print("evens", evens{});
+    print("odds", odds{});
+    print("reversed evens", reverse_t<evens>{});
+    print("concat", concat_t<evens, odds>{});
+    print("sorted", sort(concat(evens{}, odds{})));
+    print("sliced", slice_t<sort_t<concat_t<evens, odds>>, 2, 5>{});
+}